@@ -1,14 +1,188 @@
+#include "framepacer.h"
 #include "raylib.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <ostream>
 #include <sys/syslimits.h>
+#include <vector>
+
+const int screenWidth = 640;
+const int screenHeight = 360;
+
+// lots of bouncing squares for the stress mode. every field has its own array
+// (instead of an array of Obstacle structs) so the loops below read floats that
+// sit next to each other in memory, that's what lets the compiler do 4 or 8
+// obstacles per instruction (SIMD)
+struct Obstacles {
+  std::vector<float> x, y;
+  // pixels/second
+  std::vector<float> velocityX, velocityY;
+  std::vector<float> size;
+  // 1 when touching the circle, unsigned char instead of bool so it can be
+  // written in the same vectorized loop
+  std::vector<unsigned char> hit;
+
+  void spawn(int count) {
+    x.resize(count);
+    y.resize(count);
+    velocityX.resize(count);
+    velocityY.resize(count);
+    size.resize(count);
+    hit.resize(count);
+    for (int i = 0; i < count; i++) {
+      size[i] = GetRandomValue(4, 40);
+      x[i] = GetRandomValue(0, screenWidth - size[i]);
+      y[i] = GetRandomValue(0, screenHeight - size[i]);
+      velocityX[i] = GetRandomValue(-300, 300);
+      velocityY[i] = GetRandomValue(-300, 300);
+    }
+  }
+
+  // frame rate independent, everything moves by velocity * dT
+  void update(float dT) {
+    const int count = x.size();
+    for (int i = 0; i < count; i++) {
+      float maxX = screenWidth - size[i];
+      float maxY = screenHeight - size[i];
+      float newX = x[i] + velocityX[i] * dT;
+      float newY = y[i] + velocityY[i] * dT;
+
+      // bounce, written as selects instead of ifs so there's no branch that
+      // stops the loop from being vectorized
+      velocityX[i] = (newX < 0 || newX > maxX) ? -velocityX[i] : velocityX[i];
+      velocityY[i] = (newY < 0 || newY > maxY) ? -velocityY[i] : velocityY[i];
+      x[i] = std::min(std::max(newX, 0.0f), maxX);
+      y[i] = std::min(std::max(newY, 0.0f), maxY);
+    }
+  }
+
+  // circle vs every square, returns how many are touching it. the closest
+  // point of the square to the circle center is the center clamped to the
+  // square, if it's within the radius they collide
+  int collide(float circleX, float circleY, float radius) {
+    const int count = x.size();
+    const float radiusSquared = radius * radius;
+    int hits = 0;
+    for (int i = 0; i < count; i++) {
+      float closestX = std::min(std::max(circleX, x[i]), x[i] + size[i]);
+      float closestY = std::min(std::max(circleY, y[i]), y[i] + size[i]);
+      float dx = circleX - closestX;
+      float dy = circleY - closestY;
+      hit[i] = dx * dx + dy * dy <= radiusSquared;
+      hits += hit[i];
+    }
+    return hits;
+  }
+};
+
+// pacing mode and frame time, F1 changes the mode
+void drawPacing(const FramePacer &pacer, int x, int y) {
+  const FrameTimeStats &stats = pacer.getStats();
+  DrawText(TextFormat("%s %d (F1), frame %.2fms +/- %.3fms",
+                      pacer.getModeName(), pacer.getTargetFps(),
+                      stats.mean() * 1000, stats.stdDev() * 1000),
+           x, y, 10, WHITE);
+}
+
+// `./mygame --stress 20000` bounces that many squares around instead of
+// playing, it's a quick CPU benchmark for the collision math. build with
+// -DCMAKE_BUILD_TYPE=Release, the default Debug build isn't optimized (so not
+// vectorized either). V toggles drawing, to time only the update and collision
+void runStress(int count, FramePacer &pacer) {
+  Obstacles obstacles;
+  obstacles.spawn(count);
+
+  float circleX = screenWidth / 2.0f;
+  float circleY = screenHeight / 2.0f;
+  const float circleRadius = 25;
+  bool drawObstacles = true;
+
+  // smoothed so the numbers can be read
+  double updateMs = 0;
+  double collideMs = 0;
+
+  while (!WindowShouldClose()) {
+    float dT = GetFrameTime();
+
+    float circleSpeed = IsKeyDown(KEY_LEFT_SHIFT) ? 480 : 240;
+    if (IsKeyDown(KEY_A)) {
+      circleX -= circleSpeed * dT;
+    }
+    if (IsKeyDown(KEY_D)) {
+      circleX += circleSpeed * dT;
+    }
+    if (IsKeyDown(KEY_W)) {
+      circleY -= circleSpeed * dT;
+    }
+    if (IsKeyDown(KEY_S)) {
+      circleY += circleSpeed * dT;
+    }
+    if (IsKeyPressed(KEY_V)) {
+      drawObstacles = !drawObstacles;
+    }
+    pacer.record();
+    if (IsKeyPressed(KEY_F1)) {
+      pacer.cycleMode();
+    }
+
+    double start = GetTime();
+    obstacles.update(dT);
+    double updated = GetTime();
+    int hits = obstacles.collide(circleX, circleY, circleRadius);
+    double collided = GetTime();
+
+    updateMs = updateMs * 0.95 + (updated - start) * 1000 * 0.05;
+    collideMs = collideMs * 0.95 + (collided - updated) * 1000 * 0.05;
+
+    BeginDrawing();
+    ClearBackground(BLUE);
+
+    if (drawObstacles) {
+      for (int i = 0; i < count; i++) {
+        DrawRectangle(obstacles.x[i], obstacles.y[i], obstacles.size[i],
+                      obstacles.size[i], obstacles.hit[i] ? RED : BLACK);
+      }
+    }
+    DrawCircle(circleX, circleY, circleRadius, WHITE);
+
+    DrawRectangle(0, 0, 330, 64, Fade(BLACK, 0.6));
+    DrawText(TextFormat("%d obstacles, %d touching", count, hits), 8, 6, 10,
+             WHITE);
+    DrawText(TextFormat("update %.3fms, collision %.3fms", updateMs, collideMs),
+             8, 20, 10, WHITE);
+    DrawText(TextFormat("%d fps, V toggles drawing", GetFPS()), 8, 34, 10,
+             WHITE);
+    drawPacing(pacer, 8, 48);
+
+    EndDrawing();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int stressCount = 0;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+      stressCount = std::atoi(argv[++i]);
+    }
+  }
+
+  // the stress mode is uncapped, the fps is part of the benchmark. the game
+  // moves a fixed amount per frame, so it's capped at 60. --vsync, --fps <n>
+  // and --uncapped override both
+  FramePacer pacer(stressCount > 0 ? PacingMode::UNCAPPED : PacingMode::CAPPED);
+  pacer.parseArgs(argc, argv);
 
-int main() {
-  const int screenWidth = 640;
-  const int screenHeight = 360;
   InitWindow(screenWidth, screenHeight, "Axe Game");
+  pacer.apply();
 
-  SetTargetFPS(60);
+  if (stressCount > 0) {
+    runStress(stressCount, pacer);
+    pacer.printStats();
+    CloseWindow();
+    return 0;
+  }
 
   int circleRadius = 25;
   int circleX = 0;
@@ -37,6 +211,11 @@ int main() {
   bool collided = false;
 
   while (!WindowShouldClose()) {
+    pacer.record();
+    if (IsKeyPressed(KEY_F1)) {
+      pacer.cycleMode();
+    }
+
     BeginDrawing();
 
     if (!collided) {
@@ -95,9 +274,12 @@ int main() {
       }
     }
 
+    drawPacing(pacer, 8, 8);
+
     EndDrawing();
   }
 
+  pacer.printStats();
   CloseWindow();
 
   return 0;
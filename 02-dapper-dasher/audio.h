@@ -0,0 +1,281 @@
+#ifndef audio_h
+#define audio_h
+
+#include "raylib.h"
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// what happens when a cue is played while all of its voices are still busy
+enum class Retrigger {
+  // cut the oldest voice and start over with it, good for short sounds that
+  // should always be heard (landing)
+  STEAL_OLDEST,
+  // drop the new play, good for sounds that shouldn't pile up (grunts)
+  IGNORE,
+};
+
+struct CueRules {
+  // how many copies of each clip can play at the same time
+  int voices = 1;
+  // minimum seconds between two plays of the cue, plays inside it are dropped
+  double cooldown = 0;
+  Retrigger retrigger = Retrigger::STEAL_OLDEST;
+  float volume = 1.0;
+  // random pitch in [1 - variation, 1 + variation] on every play, so repeated
+  // sounds like footsteps don't sound like a machine gun
+  float pitchVariation = 0;
+  // cut the silence at the start of the file so it plays right when triggered
+  bool trimLeadingSilence = false;
+};
+
+// small audio engine on top of raylib sounds.
+//
+// every clip is decoded to PCM once when it's loaded (LoadSoundFromWave), so
+// playing it is just pointing a voice at memory, no file reads or stream seeks
+// while the game is running. voices are sound aliases, they share the PCM of
+// their clip and only have their own playback state. all of them come from a
+// fixed pool that is handed out at load time, playing never allocates.
+//
+// a cue is what the game asks to play: one or more clips (variants, a random
+// one is picked every time) plus the rules of when it's allowed to play.
+class AudioEngine {
+
+private:
+  static const int MAX_VOICES = 40;
+
+  struct Voice {
+    Sound sound;
+    double startedAt;
+  };
+
+  struct Clip {
+    // owns the decoded PCM, never played directly
+    Sound sound;
+    int firstVoice;
+    int voiceCount;
+  };
+
+  struct Cue {
+    CueRules rules;
+    int firstClip;
+    int clipCount;
+    double lastPlayed;
+    int lastClip;
+  };
+
+  std::array<Voice, MAX_VOICES> voices_;
+  int voiceCount_{0};
+  std::vector<Clip> clips_;
+  std::vector<Cue> cues_;
+
+  int droppedPlays_{0};
+
+public:
+  AudioEngine() {}
+  AudioEngine(const AudioEngine &) = delete;
+  AudioEngine &operator=(const AudioEngine &) = delete;
+
+  ~AudioEngine() { unload(); }
+
+  // the whole file is one clip
+  int loadCue(const char *path, const CueRules &rules) {
+    int cue = beginCue(rules);
+    addClip(cue, LoadWave(path));
+    return cue;
+  }
+
+  // every file is a variant of the same cue
+  int loadCue(const std::vector<std::string> &paths, const CueRules &rules) {
+    int cue = beginCue(rules);
+    for (const std::string &path : paths) {
+      addClip(cue, LoadWave(path.c_str()));
+    }
+    return cue;
+  }
+
+  // cuts [start, start + length] seconds out of a wave, for files that have
+  // several sounds in them
+  int loadCue(const Wave &wave, float start, float length,
+              const CueRules &rules) {
+    int cue = beginCue(rules);
+
+    if (wave.data == nullptr) {
+      // file failed to load, raylib already logged it. the cue stays silent
+      return cue;
+    }
+
+    Wave slice = WaveCopy(wave);
+    int initFrame = static_cast<int>(start * wave.sampleRate);
+    int finalFrame = static_cast<int>((start + length) * wave.sampleRate);
+    if (finalFrame > static_cast<int>(wave.frameCount)) {
+      finalFrame = wave.frameCount;
+    }
+    WaveCrop(&slice, initFrame, finalFrame);
+    addClip(cue, slice);
+    return cue;
+  }
+
+  void play(int cue) {
+    assert(cue >= 0 && cue < static_cast<int>(cues_.size()));
+    Cue &c = cues_[cue];
+    if (c.clipCount == 0) {
+      return;
+    }
+
+    double now = GetTime();
+    if (c.lastPlayed >= 0 && now - c.lastPlayed < c.rules.cooldown) {
+      droppedPlays_++;
+      return;
+    }
+
+    // random variant, but never the same one twice in a row
+    int clip = c.firstClip;
+    if (c.clipCount > 1) {
+      clip += std::rand() % (c.clipCount - 1);
+      if (clip >= c.lastClip) {
+        clip++;
+      }
+    }
+
+    Voice *voice = findVoice(clips_[clip], c.rules.retrigger);
+    if (voice == nullptr) {
+      droppedPlays_++;
+      return;
+    }
+
+    if (c.rules.pitchVariation > 0) {
+      float random = static_cast<float>(std::rand()) / RAND_MAX;
+      SetSoundPitch(voice->sound,
+                    1.0 + c.rules.pitchVariation * (random * 2 - 1));
+    }
+
+    // PlaySound on a voice that is still playing restarts it
+    PlaySound(voice->sound);
+    voice->startedAt = now;
+    c.lastPlayed = now;
+    c.lastClip = clip;
+  }
+
+  void stop(int cue) {
+    const Cue &c = cues_[cue];
+    for (int i = c.firstClip; i < c.firstClip + c.clipCount; i++) {
+      for (int v = 0; v < clips_[i].voiceCount; v++) {
+        StopSound(voices_[clips_[i].firstVoice + v].sound);
+      }
+    }
+  }
+
+  int getActiveVoices() const {
+    int active = 0;
+    for (int i = 0; i < voiceCount_; i++) {
+      if (IsSoundPlaying(voices_[i].sound)) {
+        active++;
+      }
+    }
+    return active;
+  }
+
+  int getVoiceCount() const { return voiceCount_; }
+  int getDroppedPlays() const { return droppedPlays_; }
+
+  // ⚠️ has to be called before CloseAudioDevice
+  void unload() {
+    for (int i = 0; i < voiceCount_; i++) {
+      UnloadSoundAlias(voices_[i].sound);
+    }
+    for (Clip &clip : clips_) {
+      UnloadSound(clip.sound);
+    }
+    voiceCount_ = 0;
+    clips_.clear();
+    cues_.clear();
+  }
+
+private:
+  int beginCue(const CueRules &rules) {
+    Cue cue;
+    cue.rules = rules;
+    cue.firstClip = clips_.size();
+    cue.clipCount = 0;
+    cue.lastPlayed = -1;
+    cue.lastClip = -1;
+    cues_.push_back(cue);
+    return cues_.size() - 1;
+  }
+
+  // clips of a cue have to be added right after it, so they stay contiguous
+  void addClip(int cue, Wave wave) {
+    Cue &c = cues_[cue];
+    assert(c.firstClip + c.clipCount == static_cast<int>(clips_.size()));
+
+    if (wave.data == nullptr) {
+      return;
+    }
+
+    if (c.rules.trimLeadingSilence) {
+      trimLeadingSilence(wave);
+    }
+
+    Clip clip;
+    clip.sound = LoadSoundFromWave(wave);
+    UnloadWave(wave);
+
+    // 🚨 the pool is fixed, raise MAX_VOICES if you add more sounds
+    assert(voiceCount_ + c.rules.voices <= MAX_VOICES);
+    clip.firstVoice = voiceCount_;
+    clip.voiceCount = c.rules.voices;
+    for (int i = 0; i < clip.voiceCount; i++) {
+      Voice &voice = voices_[voiceCount_++];
+      voice.sound = LoadSoundAlias(clip.sound);
+      voice.startedAt = -1;
+      SetSoundVolume(voice.sound, c.rules.volume);
+    }
+
+    clips_.push_back(clip);
+    c.clipCount++;
+  }
+
+  Voice *findVoice(const Clip &clip, Retrigger retrigger) {
+    Voice *oldest = nullptr;
+    for (int i = clip.firstVoice; i < clip.firstVoice + clip.voiceCount; i++) {
+      Voice &voice = voices_[i];
+      if (!IsSoundPlaying(voice.sound)) {
+        return &voice;
+      }
+      if (oldest == nullptr || voice.startedAt < oldest->startedAt) {
+        oldest = &voice;
+      }
+    }
+    return retrigger == Retrigger::STEAL_OLDEST ? oldest : nullptr;
+  }
+
+  // anything quieter than this (in a -1 to 1 float sample) counts as silence
+  static void trimLeadingSilence(Wave &wave, float threshold = 0.02) {
+    // float samples make the check the same for any bit depth
+    WaveFormat(&wave, wave.sampleRate, 32, wave.channels);
+    const float *samples = static_cast<const float *>(wave.data);
+
+    unsigned int frame = 0;
+    for (; frame < wave.frameCount; frame++) {
+      bool loud = false;
+      for (unsigned int ch = 0; ch < wave.channels; ch++) {
+        if (std::fabs(samples[frame * wave.channels + ch]) > threshold) {
+          loud = true;
+        }
+      }
+      if (loud) {
+        break;
+      }
+    }
+
+    if (frame > 0 && frame < wave.frameCount) {
+      WaveCrop(&wave, frame, wave.frameCount);
+    }
+  }
+};
+
+#endif
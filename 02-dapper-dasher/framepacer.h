@@ -0,0 +1,133 @@
+#ifndef framepacer_h
+#define framepacer_h
+
+#include "raylib.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+enum class PacingMode { VSYNC, CAPPED, UNCAPPED };
+
+// rolling window of the last frame times, mean and variance are computed from
+// running sums so reading them is O(1) no matter how big the window is
+class FrameTimeStats {
+  static const int SAMPLE_COUNT = 240;
+  double samples_[SAMPLE_COUNT];
+  int next_{0};
+  int count_{0};
+  double sum_{0};
+  double sumSquared_{0};
+
+public:
+  void reset() {
+    next_ = count_ = 0;
+    sum_ = sumSquared_ = 0;
+  }
+
+  void record(double seconds) {
+    if (count_ == SAMPLE_COUNT) {
+      // window is full, the oldest sample leaves before the new one comes in
+      sum_ -= samples_[next_];
+      sumSquared_ -= samples_[next_] * samples_[next_];
+    } else {
+      count_++;
+    }
+    samples_[next_] = seconds;
+    sum_ += seconds;
+    sumSquared_ += seconds * seconds;
+    next_ = (next_ + 1) % SAMPLE_COUNT;
+  }
+
+  double mean() const { return count_ ? sum_ / count_ : 0; }
+  double variance() const {
+    if (count_ < 2) {
+      return 0;
+    }
+    double m = mean();
+    // float rounding on the running sums can make it slightly negative
+    double v = sumSquared_ / count_ - m * m;
+    return v > 0 ? v : 0;
+  }
+  double stdDev() const { return std::sqrt(variance()); }
+};
+
+// how frames are paced, raylib does the waiting in EndDrawing():
+// - VSYNC: FLAG_VSYNC_HINT, the driver waits for the monitor
+// - CAPPED: SetTargetFPS(n), raylib sleeps most of the frame and spins the
+//   rest, so it wakes up on time
+// - UNCAPPED: no waiting at all, for benchmarking
+//
+// picked with --vsync, --fps <n> or --uncapped, F1 cycles through them
+class FramePacer {
+
+private:
+  PacingMode mode_;
+  int targetFps_{60};
+  FrameTimeStats stats_;
+
+public:
+  explicit FramePacer(PacingMode mode) : mode_(mode) {}
+
+  void parseArgs(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+      if (std::strcmp(argv[i], "--vsync") == 0) {
+        mode_ = PacingMode::VSYNC;
+      } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+        mode_ = PacingMode::CAPPED;
+        targetFps_ = std::atoi(argv[++i]);
+        if (targetFps_ <= 0) {
+          targetFps_ = 60;
+        }
+      } else if (std::strcmp(argv[i], "--uncapped") == 0) {
+        mode_ = PacingMode::UNCAPPED;
+      }
+    }
+  }
+
+  // needs the window to be open already
+  void apply() {
+    if (mode_ == PacingMode::VSYNC) {
+      SetWindowState(FLAG_VSYNC_HINT);
+    } else {
+      ClearWindowState(FLAG_VSYNC_HINT);
+    }
+    SetTargetFPS(mode_ == PacingMode::CAPPED ? targetFps_ : 0);
+    // the frames of the old mode say nothing about the new one
+    stats_.reset();
+  }
+
+  void cycleMode() {
+    mode_ = static_cast<PacingMode>((static_cast<int>(mode_) + 1) % 3);
+    apply();
+  }
+
+  // once per frame, GetFrameTime() is how long the last frame took, waiting
+  // included
+  void record() { stats_.record(GetFrameTime()); }
+
+  const FrameTimeStats &getStats() const { return stats_; }
+  int getTargetFps() const { return targetFps_; }
+
+  const char *getModeName() const {
+    switch (mode_) {
+    case PacingMode::VSYNC:
+      return "vsync";
+    case PacingMode::CAPPED:
+      return "capped";
+    case PacingMode::UNCAPPED:
+      return "uncapped";
+    }
+    return "unknown";
+  }
+
+  // useful with --uncapped to compare performance between builds
+  void printStats() const {
+    std::cout << "Frame time (" << getModeName() << "): mean "
+              << stats_.mean() * 1000 << "ms, std dev "
+              << stats_.stdDev() * 1000 << "ms, variance "
+              << stats_.variance() * 1000 * 1000 << "ms^2" << std::endl;
+  }
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef hud_h
+#define hud_h
+
+#include "raylib.h"
+#include <string>
+
+// a piece of the HUD (a line of text, the health bar...) drawn once into its
+// own render texture. every frame it costs a single textured quad, the text and
+// shapes inside are only drawn again when what it shows changes.
+//
+//   if (widget.needsRedraw(TextFormat("%d", health))) {
+//     widget.begin(BLANK);
+//     DrawText(...);
+//     widget.end();
+//   }
+//   widget.draw(position);
+class HudWidget {
+
+private:
+  RenderTexture2D target_{};
+  // what the widget was last drawn with, compared with what the caller shows
+  std::string content_;
+  bool drawn_{false};
+  int redraws_{0};
+
+public:
+  HudWidget() {}
+  HudWidget(const HudWidget &) = delete;
+  HudWidget &operator=(const HudWidget &) = delete;
+
+  // needs the window to be open already
+  void load(int width, int height) {
+    target_ = LoadRenderTexture(width, height);
+    drawn_ = false;
+  }
+
+  void unload() { UnloadRenderTexture(target_); }
+
+  // true when `content` isn't what the widget was last drawn with, the caller
+  // draws it again between begin() and end()
+  bool needsRedraw(const char *content) {
+    if (drawn_ && content_ == content) {
+      return false;
+    }
+    content_ = content;
+    drawn_ = true;
+    return true;
+  }
+
+  // what's drawn until end() goes into the widget, with (0, 0) at its top left
+  // corner. `background` fills it first, BLANK leaves it transparent
+  void begin(Color background) {
+    BeginTextureMode(target_);
+    ClearBackground(background);
+  }
+
+  void end() {
+    EndTextureMode();
+    redraws_++;
+  }
+
+  void draw(Vector2 position) const {
+    // render textures are upside down, the negative height flips it back
+    Rectangle src{0, 0, (float)target_.texture.width,
+                  -(float)target_.texture.height};
+    DrawTextureRec(target_.texture, src, position, WHITE);
+  }
+
+  int getRedraws() const { return redraws_; }
+};
+
+#endif
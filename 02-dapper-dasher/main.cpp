@@ -1,3 +1,6 @@
+#include "audio.h"
+#include "framepacer.h"
+#include "hud.h"
 #include "raylib.h"
 #include <array>
 #include <cstdlib>
@@ -23,15 +26,11 @@ bool isColliding(const Rectangle &A, const Rectangle &B) {
   return false;
 }
 
-class Entity {
-public:
-  Entity() {}
-
-  virtual void update(double dT) {}
-  virtual void draw() {}
-};
-
-class Background : public Entity {
+// there's no Entity base class on purpose, every kind of entity lives in its
+// own contiguous container and gets its own pass in the main loop. the compiler
+// knows the exact type in each pass, so update/draw are plain (inlinable) calls
+// and we never have to ask an entity what it is with a dynamic_cast
+class Background {
 
 private:
   Texture2D texture_;
@@ -54,7 +53,7 @@ public:
     velocity_ = velocity;
   }
 
-  void update(double dT) override {
+  void update(double dT) {
     xPos_ -= velocity_ * dT;
 
     if (xPos_ <= -scaledWidth_) {
@@ -65,92 +64,244 @@ public:
     secondPos_.x = xPos_ + scaledWidth_;
   }
 
-  void draw() override {
+  void draw() {
     DrawTextureEx(texture_, firstPos_, 0.0, textureScale_, WHITE);
     DrawTextureEx(texture_, secondPos_, 0.0, textureScale_, WHITE);
   }
 };
 
-class Fireball : public Entity {
+// every fireball on screen, stored as packed arrays instead of one object per
+// fireball: the update and the collision test are tight loops over just the
+// data they need, so hundreds of fireballs cost about the same as a few.
+//
+// live fireballs are always [0, count), removing one moves the last one into
+// its place. the arrays are reserved up front so spawning never allocates
+class FireballPool {
 
 private:
+  static const int MAX_FIREBALLS = 1024;
+  // seconds a fireball stays on the hero before it goes away
+  static constexpr double HIT_DURATION = 0.15;
+
   int spriteFrameCount_ = 5;
   Rectangle srcRect_;
-  float initialPosY = 0;
-  float initialPosX = 0;
+  float width_{0};
+  float height_{0};
 
 public:
-  int velocity = -500;
-  bool colliding = false;
-  Rectangle destRect;
-  Fireball(int velocity, int posOffsetX, int posOffsetY) : velocity(velocity) {
+  std::vector<Rectangle> destRects;
+  std::vector<float> velocities;
+  std::vector<float> collidingDurations;
+  std::vector<unsigned char> colliding;
 
+  FireballPool() {
     srcRect_.width = (float)textureFire.width / spriteFrameCount_;
     srcRect_.height = textureFire.height;
     srcRect_.x = 0;
     srcRect_.y = 0;
+    width_ = srcRect_.width * 2.5;
+    height_ = srcRect_.height * 2.5;
+
+    destRects.reserve(MAX_FIREBALLS);
+    velocities.reserve(MAX_FIREBALLS);
+    collidingDurations.reserve(MAX_FIREBALLS);
+    colliding.reserve(MAX_FIREBALLS);
+  }
+
+  int size() const { return destRects.size(); }
 
-    initialPosX = screenWidth + posOffsetX;
-    initialPosY = screenHeight - (40 + posOffsetY) * 2.5;
+  // posOffsetY is how high above the ground it flies
+  void spawn(float velocity, float posOffsetX, float posOffsetY) {
+    if (size() == MAX_FIREBALLS) {
+      return;
+    }
+    destRects.push_back(Rectangle{screenWidth + posOffsetX,
+                                  screenHeight - (40 + posOffsetY) * 2.5f,
+                                  width_, height_});
+    velocities.push_back(velocity);
+    collidingDurations.push_back(0);
+    colliding.push_back(0);
+  }
 
-    destRect.x = initialPosX;
-    destRect.y = initialPosY;
-    destRect.width = srcRect_.width * 2.5;
-    destRect.height = srcRect_.height * 2.5;
+  void clear() {
+    destRects.clear();
+    velocities.clear();
+    collidingDurations.clear();
+    colliding.clear();
   }
 
-  double collidingDuration = 0;
-  void update(const double dT) override {
-    if (colliding) {
-      collidingDuration += dT;
-    } else {
-      collidingDuration = 0;
+  // flags every fireball touching the hero, returns how many are touching and
+  // how many just started touching this frame (those are the ones that hurt)
+  int collide(const Rectangle &hero, int &newHits) {
+    int touching = 0;
+    newHits = 0;
+    const int count = size();
+    for (int i = 0; i < count; i++) {
+      unsigned char hit = isColliding(destRects[i], hero);
+      newHits += hit & !colliding[i];
+      touching += hit;
+      colliding[i] = hit;
     }
+    return touching;
+  }
 
-    destRect.x += velocity * dT;
-    if (destRect.x < -destRect.width) {
-      destRect.x = initialPosX;
+  void update(const double dT) {
+    const int count = size();
+    for (int i = 0; i < count; i++) {
+      destRects[i].x += velocities[i] * dT;
+      collidingDurations[i] = colliding[i] ? collidingDurations[i] + dT : 0;
     }
 
-    if (collidingDuration > 0.15) {
-      destRect.x = initialPosX;
+    // remove the ones that left the screen or already burned the hero,
+    // backwards so the one moved into the hole was already checked
+    for (int i = count - 1; i >= 0; i--) {
+      if (destRects[i].x < -width_ || collidingDurations[i] > HIT_DURATION) {
+        remove(i);
+      }
     }
 
-    // 1/8 means 8 changes every second
+    // 1/8 means 8 changes every second, all fireballs share the same frame
     srcRect_.x = srcRect_.width *
                  (static_cast<int>(elapsed / (1.0 / 12)) % spriteFrameCount_);
   }
 
-  void draw() override {
-    DrawTexturePro(textureFire, srcRect_, destRect, Vector2{0, 0}, 0,
-                   colliding ? BLACK : WHITE);
+  void draw() {
+    const int count = size();
+    for (int i = 0; i < count; i++) {
+      DrawTexturePro(textureFire, srcRect_, destRects[i], Vector2{0, 0}, 0,
+                     colliding[i] ? BLACK : WHITE);
+    }
+  }
+
+private:
+  void remove(int i) {
+    destRects[i] = destRects.back();
+    velocities[i] = velocities.back();
+    collidingDurations[i] = collidingDurations.back();
+    colliding[i] = colliding.back();
+    destRects.pop_back();
+    velocities.pop_back();
+    collidingDurations.pop_back();
+    colliding.pop_back();
+  }
+};
+
+// how the fireballs get harder over a run. everything goes from the start
+// value to the hardest value in rampTime seconds
+struct Difficulty {
+  const char *name;
+  // seconds between two spawns
+  float startInterval, minInterval;
+  // pixels/second, to the left
+  float startSpeed, maxSpeed;
+  float rampTime;
+  // fireballs come at this many heights, 1 is only on the ground
+  int lanes;
+};
+
+// selected with the number keys, the last one is there to stress test with
+// hundreds of fireballs on screen
+const Difficulty DIFFICULTIES[] = {
+    {"easy", 1.6, 0.9, 500, 800, 120, 1},
+    {"normal", 1.2, 0.5, 600, 1100, 90, 1},
+    {"hard", 0.9, 0.3, 700, 1400, 60, 2},
+    {"inferno", 0.05, 0.005, 600, 1400, 30, 6},
+};
+const int DIFFICULTY_COUNT = sizeof(DIFFICULTIES) / sizeof(DIFFICULTIES[0]);
+
+class FireballSpawner {
+
+private:
+  // a second to get ready before the first one
+  static constexpr double GRACE_TIME = 1.0;
+
+  double runTime_{0};
+  double untilNextSpawn_{GRACE_TIME};
+
+public:
+  int difficulty = 1;
+
+  void reset() {
+    runTime_ = 0;
+    untilNextSpawn_ = GRACE_TIME;
+  }
+
+  void update(const double dT, FireballPool &pool) {
+    const Difficulty &d = DIFFICULTIES[difficulty];
+    runTime_ += dT;
+    float progress = runTime_ < d.rampTime ? runTime_ / d.rampTime : 1;
+
+    untilNextSpawn_ -= dT;
+    // more than one spawn per frame when the interval is shorter than a frame
+    while (untilNextSpawn_ <= 0) {
+      float interval =
+          d.startInterval + (d.minInterval - d.startInterval) * progress;
+      float speed = d.startSpeed + (d.maxSpeed - d.startSpeed) * progress;
+      // +-10% so they don't all look glued together
+      float jitter = 0.9 + 0.2 * (static_cast<float>(std::rand()) / RAND_MAX);
+      int lane = std::rand() % d.lanes;
+
+      // the spawn that was late is placed where it would already be
+      pool.spawn(-speed * jitter, untilNextSpawn_ * speed * jitter, lane * 40);
+      untilNextSpawn_ += interval;
+    }
   }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
   std::srand(std::time(nullptr));
-  std::vector<Entity *> entities;
+  // capped at 60 unless --vsync, --fps <n> or --uncapped say otherwise
+  FramePacer pacer(PacingMode::CAPPED);
+  pacer.parseArgs(argc, argv);
+  // drawn in this order, backgrounds first (back to front) then fireballs
+  std::vector<Background> backgrounds;
 
   InitWindow(screenWidth, screenHeight, "Dapper Dasher");
   InitAudioDevice();
 
   Sound backgroundSound = LoadSound("./assets/ridiculousgravewalk.ogg");
-  Sound jumpLandingSound = LoadSound("./assets/jump_landing.mp3");
   SetSoundVolume(backgroundSound, 0.8);
   PlaySound(backgroundSound);
 
-  Music grunts = LoadMusicStream("./assets/grunts.wav");
-
-  std::array<float, 2> deathGrunt = {0.5, 1.8};
-
+  // all the short sounds are decoded up front, see audio.h
+  AudioEngine audio;
+
+  // the file has a lot of silence before the landing, it used to be played on
+  // every frame in the air so it would restart until the hero landed. now the
+  // silence is cut and it's played once on the landing
+  CueRules landingRules;
+  landingRules.voices = 2;
+  landingRules.cooldown = 0.1;
+  landingRules.trimLeadingSilence = true;
+  const int landingCue =
+      audio.loadCue("./assets/jump_landing.mp3", landingRules);
+
+  std::vector<std::string> stepPaths;
+  for (int i = 1; i <= 25; i++) {
+    stepPaths.push_back(
+        TextFormat("./assets/metal_steps_48k24b/metal_steps_%02d.wav", i));
+  }
+  CueRules stepRules;
+  stepRules.cooldown = 0.15;
+  stepRules.volume = 0.4;
+  stepRules.pitchVariation = 0.05;
+  const int stepsCue = audio.loadCue(stepPaths, stepRules);
+
+  // grunts.wav has all the grunts one after the other, each one is cut into
+  // its own clip instead of seeking a music stream around on every hit
+  Wave grunts = LoadWave("./assets/grunts.wav");
+
+  CueRules hurtRules;
+  hurtRules.cooldown = 0.3;
+  hurtRules.retrigger = Retrigger::IGNORE;
   const int HURT_GRUNT_SIZE = 2;
-  std::array<std::array<float, 2>, HURT_GRUNT_SIZE> hurtGrunts;
-  hurtGrunts[0] = {39, 0.5};
-  hurtGrunts[1] = {7, 0.5};
+  std::array<int, HURT_GRUNT_SIZE> hurtGruntCues;
+  hurtGruntCues[0] = audio.loadCue(grunts, 39, 0.5, hurtRules);
+  hurtGruntCues[1] = audio.loadCue(grunts, 7, 0.5, hurtRules);
 
-  std::array<float, 2> playingGrunt = hurtGrunts[0];
+  const int deathGruntCue = audio.loadCue(grunts, 0.5, 1.8, CueRules());
 
-  float gruntPlayedAt = elapsed;
+  UnloadWave(grunts);
 
   // Move the window to the right side of the monitor
   int monitor = GetCurrentMonitor();
@@ -170,22 +321,16 @@ int main() {
 
   Texture2D textureGraves = LoadTexture("./assets/background/graves.png");
 
-  Background bgSky{textureSky, 20};
-  Background gravesBg{textureGraves, 30};
-  Background backTreesBg{LoadTexture("./assets/background/back_trees.png"), 40};
-  Background cryptBg{LoadTexture("./assets/background/crypt.png"), 45};
-  Background wallBg{LoadTexture("./assets/background/wall.png"), 50};
-  Background groundBg{LoadTexture("./assets/background/ground.png"), 100};
-  Background treeBg{LoadTexture("./assets/background/tree.png"), 100};
-  Background bonesBg{LoadTexture("./assets/background/bones.png"), 100};
-  entities.push_back(&bgSky);
-  entities.push_back(&gravesBg);
-  entities.push_back(&backTreesBg);
-  entities.push_back(&cryptBg);
-  entities.push_back(&wallBg);
-  entities.push_back(&groundBg);
-  entities.push_back(&treeBg);
-  entities.push_back(&bonesBg);
+  backgrounds.reserve(8);
+  backgrounds.emplace_back(textureSky, 20);
+  backgrounds.emplace_back(textureGraves, 30);
+  backgrounds.emplace_back(LoadTexture("./assets/background/back_trees.png"),
+                           40);
+  backgrounds.emplace_back(LoadTexture("./assets/background/crypt.png"), 45);
+  backgrounds.emplace_back(LoadTexture("./assets/background/wall.png"), 50);
+  backgrounds.emplace_back(LoadTexture("./assets/background/ground.png"), 100);
+  backgrounds.emplace_back(LoadTexture("./assets/background/tree.png"), 100);
+  backgrounds.emplace_back(LoadTexture("./assets/background/bones.png"), 100);
 
   // acceleration due to gravity (pixel/second)/second
   const int gravity = 3400;
@@ -197,7 +342,8 @@ int main() {
   Texture2D textureWalk = LoadTexture("./assets/hero/Walk.png");
   int textureWalkSprites = 8;
 
-  Texture2D textureRun = LoadTexture("./assets/hero/Run.png");
+  // Run.png is never drawn (the hero runs with the walk sheet), only its frame
+  // count paces the animation, so it isn't loaded
   int textureRunSprites = 7;
 
   Texture2D textureDead = LoadTexture("./assets/hero/Dead.png");
@@ -234,28 +380,48 @@ int main() {
 
   const float groundPos = heroPos.y;
 
-  Fireball fireOne{-600, 400, 0};
-  Fireball fireTwo{-600, 1000, 0};
-  entities.push_back(&fireOne);
-  entities.push_back(&fireTwo);
+  FireballPool fireballs;
+  FireballSpawner spawner;
+
+  // the HUD is drawn into textures and only drawn again when it changes, see
+  // hud.h
+  HudWidget statusHud;
+  statusHud.load(300, 10);
+  HudWidget healthHud;
+  healthHud.load(maxHealth, heroRectHealth.height * 2);
+  HudWidget gameOverHud;
+  gameOverHud.load(280, 76);
+  HudWidget pacingHud;
+  pacingHud.load(300, 10);
 
   Texture2D *heroTexture;
 
-  SetTargetFPS(60);
+  // to play sounds on the frame something happens instead of every frame
+  bool wasOnTheGround = true;
+  int lastRunFrame = -1;
+
+  pacer.apply();
   // Main game loop
   while (!WindowShouldClose()) {
+    pacer.record();
+    if (IsKeyPressed(KEY_F1)) {
+      pacer.cycleMode();
+    }
 
     if (dead && IsKeyReleased(KEY_R)) {
       dead = false;
       heroRectHealth.width = maxHealth;
       colliding = 0;
       heroTexture = &textureWalk;
-      for (auto &entity : entities) {
+      fireballs.clear();
+      spawner.reset();
+    }
 
-        Fireball *fireball = dynamic_cast<Fireball *>(entity);
-        if (fireball != nullptr) {
-          fireball->velocity = -600;
-        }
+    // changing the difficulty starts the curve over
+    for (int i = 0; i < DIFFICULTY_COUNT; i++) {
+      if (IsKeyPressed(KEY_ONE + i)) {
+        spawner.difficulty = i;
+        spawner.reset();
       }
     }
 
@@ -267,14 +433,17 @@ int main() {
     double dT = GetFrameTime();
     elapsed += dT;
 
-    UpdateMusicStream(grunts);
-
     BeginDrawing();
 
     ClearBackground(RAYWHITE);
 
     bool onTheGround = heroPos.y >= groundPos;
 
+    if (onTheGround && !wasOnTheGround) {
+      audio.play(landingCue);
+    }
+    wasOnTheGround = onTheGround;
+
     if (onTheGround) {
       // if the character is on the ground it should have no velocity, never
       heroPos.y = groundPos;
@@ -299,11 +468,6 @@ int main() {
       // ... and so on. Gravity is 1 and it increases velocity on every
       // iteration whenever the character is on the air
       velocityY += gravity * dT;
-
-      // play jumping sound, there's some seconds in the beggining of the audio
-      // so we can just straight play it, when the characters falls it plays at
-      // the exact time.
-      PlaySound(jumpLandingSound);
     }
 
     if (!dead) {
@@ -327,8 +491,16 @@ int main() {
                                          textureDeadSprites);
         }
       } else {
-        heroRect.x = heroRect.width * (static_cast<int>(elapsed / (1.0 / 4)) %
-                                       textureRunSprites);
+        int runFrame =
+            static_cast<int>(elapsed / (1.0 / 4)) % textureRunSprites;
+        heroRect.x = heroRect.width * runFrame;
+
+        // a foot touches the ground twice in the cycle
+        if (runFrame != lastRunFrame &&
+            (runFrame == 0 || runFrame == textureRunSprites / 2)) {
+          audio.play(stepsCue);
+        }
+        lastRunFrame = runFrame;
       }
     } else {
       // jumping sprite
@@ -340,51 +512,31 @@ int main() {
     heroPos.y += velocityY * dT;
 
     // end update animation frame of hero
-    for (auto &entity : entities) {
+    for (Background &background : backgrounds) {
+      if (!dead) {
+        background.update(dT);
+      }
+      background.draw();
+    }
 
-      Fireball *fireball = dynamic_cast<Fireball *>(entity);
+    // fireballs freeze when the hero is dead
+    if (!dead) {
+      spawner.update(dT, fireballs);
 
-      if (!dead) {
-        if (fireball != nullptr) {
-          if (isColliding(fireball->destRect, heroCollidingRect)) {
-            if (!fireball->colliding) {
-              // do the damager when first collided, which means the flag wasnt
-              // set to true yet. once it collided it's set to true, then it
-              // goes back to false when it stops colliding
-              heroRectHealth.width -= maxHealth * 1 / 3;
-
-              // find a random grunt each time
-              playingGrunt = hurtGrunts[std::rand() % (HURT_GRUNT_SIZE)];
-              gruntPlayedAt = elapsed;
-              SeekMusicStream(grunts, playingGrunt[0]);
-              PlayMusicStream(grunts);
-              colliding++;
-            }
-            fireball->colliding = true;
-          } else {
-            if (gruntPlayedAt > 0 &&
-                elapsed - gruntPlayedAt >= playingGrunt[1]) {
-              // if grunt ever played when it finishes colliding we need to stop
-              // the music
-              StopMusicStream(grunts);
-              gruntPlayedAt = 0;
-            }
-            if (fireball->colliding) {
-              colliding--;
-            }
-            fireball->colliding = false;
-          }
-        }
+      // do the damage when first collided, once it collided it keeps the flag
+      // until it stops colliding
+      int newHits = 0;
+      colliding = fireballs.collide(heroCollidingRect, newHits);
+      if (newHits > 0) {
+        heroRectHealth.width -= maxHealth * newHits / 3;
 
-        entity->update(dT);
-      } else {
-        if (fireball != nullptr) {
-          fireball->velocity = 0;
-        }
+        // find a random grunt each time
+        audio.play(hurtGruntCues[std::rand() % (HURT_GRUNT_SIZE)]);
       }
 
-      entity->draw();
+      fireballs.update(dT);
     }
+    fireballs.draw();
 
     heroCollidingRect.y = heroPos.y + heroPos.height / 2;
 
@@ -403,20 +555,48 @@ int main() {
     //                    heroCollidingRect.width, heroCollidingRect.height,
     //                    RED);
 
+    const char *status = TextFormat("%s (1-%d)  fireballs: %d  fps: %d",
+                                    DIFFICULTIES[spawner.difficulty].name,
+                                    DIFFICULTY_COUNT, fireballs.size(),
+                                    GetFPS());
+    if (statusHud.needsRedraw(status)) {
+      statusHud.begin(BLANK);
+      DrawText(status, 0, 0, 10, WHITE);
+      statusHud.end();
+    }
+    statusHud.draw(Vector2{(float)screenWidth - 300, 20});
+
+    // rounded so the widget isn't drawn again every frame
+    const FrameTimeStats &frameStats = pacer.getStats();
+    const char *pacing =
+        TextFormat("%s %d (F1)  frame: %.1fms +/- %.1fms",
+                   pacer.getModeName(), pacer.getTargetFps(),
+                   frameStats.mean() * 1000, frameStats.stdDev() * 1000);
+    if (pacingHud.needsRedraw(pacing)) {
+      pacingHud.begin(BLANK);
+      DrawText(pacing, 0, 0, 10, WHITE);
+      pacingHud.end();
+    }
+    pacingHud.draw(Vector2{(float)screenWidth - 300, 34});
+
     // draw health bar
-    DrawRectangle(heroRectHealth.x, heroRectHealth.y, maxHealth,
-                  heroRectHealth.height * 2, Color{0, 0, 0, 128});
-    DrawRectangle(heroRectHealth.x, heroRectHealth.y, heroRectHealth.width,
-                  heroRectHealth.height, RED);
-    DrawRectangle(heroRectHealth.x, heroRectHealth.y + heroRectHealth.height,
-                  heroRectHealth.width, heroRectHealth.height, MAROON);
+    if (healthHud.needsRedraw(TextFormat("%d", (int)heroRectHealth.width))) {
+      // the dark background covers all of it, no need to draw it on top
+      healthHud.begin(Color{0, 0, 0, 128});
+      DrawRectangle(0, 0, heroRectHealth.width, heroRectHealth.height, RED);
+      DrawRectangle(0, heroRectHealth.height, heroRectHealth.width,
+                    heroRectHealth.height, MAROON);
+      healthHud.end();
+    }
+    healthHud.draw(Vector2{heroRectHealth.x, heroRectHealth.y});
 
     if (heroRectHealth.width <= 0) {
       if (!dead) {
-        playingGrunt = deathGrunt;
-        SeekMusicStream(grunts, playingGrunt[0]);
-        PlayMusicStream(grunts);
-        gruntPlayedAt = elapsed;
+        // the death grunt is more important than whatever hurt grunt is on
+        for (int cue : hurtGruntCues) {
+          audio.stop(cue);
+        }
+        audio.play(deathGruntCue);
 
         // dead sprite reset to 0
         heroRect.x = 0;
@@ -424,30 +604,33 @@ int main() {
         dead = true;
       }
 
-      // after certain time passed after grunt play sound
-      if (gruntPlayedAt > 0 && elapsed - gruntPlayedAt >= playingGrunt[1]) {
-        StopMusicStream(grunts);
-        gruntPlayedAt = 0;
+      if (gameOverHud.needsRedraw("GAME OVER")) {
+        gameOverHud.begin(Color{0, 0, 0, 200});
+        DrawText("GAME OVER", 18, 10, 40, MAROON);
+        DrawText("Press R to restart", 68, 50, 16, WHITE);
+        gameOverHud.end();
       }
-
-      DrawRectangle((screenWidth / 2) - 146, (screenHeight / 2) - 10, 280, 76,
-                    Color{0, 0, 0, 200});
-      DrawText("GAME OVER", (screenWidth / 2) - 128, screenHeight / 2, 40,
-               MAROON);
-
-      DrawText("Press R to restart", (screenWidth / 2) - 78,
-               (screenHeight / 2) + 40, 16, WHITE);
+      gameOverHud.draw(Vector2{(float)(screenWidth / 2) - 146,
+                               (float)(screenHeight / 2) - 10});
     }
 
     EndDrawing();
   }
 
+  pacer.printStats();
+
   // De-Initialization
+  statusHud.unload();
+  pacingHud.unload();
+  healthHud.unload();
+  gameOverHud.unload();
   UnloadTexture(textureWalk);
   UnloadTexture(textureJump);
-  UnloadTexture(textureRun);
   UnloadTexture(textureFire);
   UnloadTexture(textureSky);
+  audio.unload();
+  UnloadSound(backgroundSound);
+  CloseAudioDevice();
   CloseWindow();
 
   return 0;
@@ -0,0 +1,200 @@
+#ifndef flowfield_h
+#define flowfield_h
+
+#include "raylib.h"
+#include "tileworld.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// distance to the target, in steps, of every tile around it
+struct FlowGrid {
+  // tile of the top left corner, the grid is size x size tiles
+  int originX{0}, originY{0};
+  int targetX{-1}, targetY{-1};
+  std::vector<uint16_t> distance;
+};
+
+// one path search shared by every enemy chasing the same target.
+//
+// a breadth first search goes out from the target's tile over the walkable
+// tiles around it, storing how many steps each tile is from the target. to
+// chase the target an enemy just moves towards the neighbour tile with the
+// smallest distance, so the cost is one search per target move no matter how
+// many enemies there are, instead of one path per enemy.
+//
+// the search only covers a square of (2 * radius + 1) tiles around the target,
+// enemies outside of it walk straight at the target until they get closer. it's
+// also spread over several frames (update() visits at most `budget` tiles) and
+// double buffered: enemies keep using the last finished grid while the next one
+// is being built
+class FlowField {
+
+private:
+  static constexpr uint16_t UNREACHED = 0xFFFF;
+
+  const TileWorld *world_{nullptr};
+  int radius_{0};
+  int size_{0};
+
+  // the one enemies read and the one being built
+  FlowGrid front_;
+  FlowGrid back_;
+  bool building_{false};
+  std::vector<int> queue_;
+  size_t queueHead_{0};
+
+  // where the target is now, the next build starts from here
+  int wantedX_{-1}, wantedY_{-1};
+
+  int builds_{0};
+  int lastVisited_{0};
+  int visiting_{0};
+
+public:
+  void init(const TileWorld *world, int radius) {
+    world_ = world;
+    radius_ = radius;
+    size_ = radius * 2 + 1;
+    front_.distance.assign(size_ * size_, UNREACHED);
+    back_.distance.assign(size_ * size_, UNREACHED);
+    queue_.reserve(size_ * size_);
+  }
+
+  // call every frame with where the target is, it's cheap when the target
+  // stays in the same tile
+  void setTarget(Vector2 position) {
+    wantedX_ = (int)(position.x / TILE_SIZE);
+    wantedY_ = (int)(position.y / TILE_SIZE);
+  }
+
+  // continues the search, visiting at most `budget` tiles
+  void update(int budget) {
+    if (!building_) {
+      if (wantedX_ == front_.targetX && wantedY_ == front_.targetY) {
+        return;
+      }
+      start();
+    }
+
+    int visited = 0;
+    while (queueHead_ < queue_.size() && visited < budget) {
+      int cell = queue_[queueHead_++];
+      int x = cell % size_;
+      int y = cell / size_;
+      uint16_t next = back_.distance[cell] + 1;
+      visit(x - 1, y, next);
+      visit(x + 1, y, next);
+      visit(x, y - 1, next);
+      visit(x, y + 1, next);
+      visited++;
+    }
+    visiting_ += visited;
+
+    if (queueHead_ == queue_.size()) {
+      // done, enemies switch to the new grid. if the target moved meanwhile the
+      // next update starts over from its current tile
+      std::swap(front_, back_);
+      building_ = false;
+      builds_++;
+      lastVisited_ = visiting_;
+    }
+  }
+
+  // unit vector pointing the way to the target from `position`
+  Vector2 getDirection(Vector2 position, Vector2 target) const {
+    int tileX = (int)(position.x / TILE_SIZE);
+    int tileY = (int)(position.y / TILE_SIZE);
+    int x = tileX - front_.originX;
+    int y = tileY - front_.originY;
+
+    uint16_t here = distanceAt(x, y);
+    if (here == UNREACHED || here == 0) {
+      // not covered by the search (or already in the target's tile), go
+      // straight at it. if a wall is in the way the caller's collision stops us
+      return normalize(Vector2{target.x - position.x, target.y - position.y});
+    }
+
+    // the neighbour closest to the target. diagonals only when both sides are
+    // open too, otherwise enemies would cut the corners of walls
+    int bestX = 0, bestY = 0;
+    uint16_t best = here;
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        uint16_t distance = distanceAt(x + dx, y + dy);
+        if (distance >= best) {
+          continue;
+        }
+        if (dx != 0 && dy != 0 &&
+            (distanceAt(x + dx, y) == UNREACHED ||
+             distanceAt(x, y + dy) == UNREACHED)) {
+          continue;
+        }
+        best = distance;
+        bestX = dx;
+        bestY = dy;
+      }
+    }
+
+    // steer to the center of that tile, so enemies don't scrape along walls
+    Vector2 center{(tileX + bestX + 0.5f) * TILE_SIZE,
+                   (tileY + bestY + 0.5f) * TILE_SIZE};
+    return normalize(Vector2{center.x - position.x, center.y - position.y});
+  }
+
+  int getBuilds() const { return builds_; }
+  // tiles visited by the last finished search
+  int getLastVisited() const { return lastVisited_; }
+  bool isBuilding() const { return building_; }
+
+private:
+  bool inside(int x, int y) const {
+    return x >= 0 && y >= 0 && x < size_ && y < size_;
+  }
+
+  uint16_t distanceAt(int x, int y) const {
+    return inside(x, y) ? front_.distance[y * size_ + x] : UNREACHED;
+  }
+
+  static Vector2 normalize(Vector2 v) {
+    float length = std::sqrt(v.x * v.x + v.y * v.y);
+    if (length == 0) {
+      return Vector2{0, 0};
+    }
+    return Vector2{v.x / length, v.y / length};
+  }
+
+  void start() {
+    back_.targetX = wantedX_;
+    back_.targetY = wantedY_;
+    back_.originX = wantedX_ - radius_;
+    back_.originY = wantedY_ - radius_;
+    std::fill(back_.distance.begin(), back_.distance.end(), UNREACHED);
+
+    queue_.clear();
+    queueHead_ = 0;
+    visiting_ = 0;
+    building_ = true;
+
+    int center = radius_ * size_ + radius_;
+    back_.distance[center] = 0;
+    queue_.push_back(center);
+  }
+
+  void visit(int x, int y, uint16_t distance) {
+    if (!inside(x, y)) {
+      return;
+    }
+    int cell = y * size_ + x;
+    if (back_.distance[cell] != UNREACHED ||
+        !world_->isWalkable(back_.originX + x, back_.originY + y)) {
+      return;
+    }
+    back_.distance[cell] = distance;
+    queue_.push_back(cell);
+  }
+};
+
+#endif
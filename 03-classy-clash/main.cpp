@@ -1,28 +1,305 @@
 #include "raylib.h"
+#include "flowfield.h"
+#include "tileworld.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
 
-int main() {
-  const int screenWidth = 800;
-  const int screenHeight = 450;
-  int price;
-  price = 20;
-  price = 25;
-  InitWindow(screenWidth, screenHeight, "template");
+const int screenWidth = 800;
+const int screenHeight = 450;
+
+// fills the world with snow, frozen lakes, stone roads and some decor. seeded,
+// so the map is the same on every run
+void generateWorld(TileWorld &world) {
+  SetRandomSeed(42);
+  const int width = world.getWidth();
+  const int height = world.getHeight();
+
+  // lakes, about one every 4 chunks
+  int lakes = width * height / (CHUNK_SIZE * CHUNK_SIZE * 4);
+  for (int i = 0; i < lakes; i++) {
+    int centerX = GetRandomValue(0, width - 1);
+    int centerY = GetRandomValue(0, height - 1);
+    int radius = GetRandomValue(3, 10);
+    for (int y = centerY - radius; y <= centerY + radius; y++) {
+      for (int x = centerX - radius; x <= centerX + radius; x++) {
+        int dx = x - centerX;
+        int dy = y - centerY;
+        if (x >= 0 && y >= 0 && x < width && y < height &&
+            dx * dx + dy * dy <= radius * radius) {
+          world.setGround(x, y, TILE_ICE);
+        }
+      }
+    }
+  }
+
+  // a grid of roads, 2 tiles wide
+  const int roadSpacing = 40;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (x % roadSpacing < 2 || y % roadSpacing < 2) {
+        world.setGround(x, y, TILE_STONE);
+      }
+    }
+  }
+
+  // decor only on snow, so lakes and roads stay clear
+  const uint8_t decor[] = {TILE_SMALL_TREE, TILE_SMALL_TREE, TILE_ROCK,
+                           TILE_LOG, TILE_SIGN};
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (world.getGround(x, y) == TILE_SNOW && GetRandomValue(0, 99) < 4) {
+        world.setDecor(x, y, decor[GetRandomValue(0, sizeof(decor) - 1)]);
+      }
+    }
+  }
+}
+
+// moves by `delta` unless that ends up inside decor. each axis is tried on its
+// own, so running into a wall at an angle slides along it
+Vector2 moveAndCollide(const TileWorld &world, Vector2 position,
+                       Vector2 delta) {
+  Vector2 next{position.x + delta.x, position.y};
+  if (world.isWalkable((int)(next.x / TILE_SIZE), (int)(next.y / TILE_SIZE))) {
+    position = next;
+  }
+  next = Vector2{position.x, position.y + delta.y};
+  if (world.isWalkable((int)(next.x / TILE_SIZE), (int)(next.y / TILE_SIZE))) {
+    position = next;
+  }
+  return position;
+}
+
+struct Orc {
+  Vector2 position;
+  float speed;
+  // how close it gets to the hero, so they surround him instead of all
+  // standing on the same spot
+  float reach;
+  float direction;
+  float animationOffset;
+};
+
+int main(int argc, char *argv[]) {
+  // world size in chunks, `./mygame --chunks 256` makes a huge map to check
+  // the frame time doesn't change with the map size
+  int worldChunks = 64;
+  // `--orcs 2000` to see how many chasing orcs we can afford
+  int orcCount = 300;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--chunks") == 0 && i + 1 < argc) {
+      worldChunks = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--orcs") == 0 && i + 1 < argc) {
+      orcCount = std::atoi(argv[++i]);
+    }
+  }
+  // atoi gives 0 for anything that isn't a number
+  if (worldChunks < 1) {
+    std::cout << "--chunks needs at least 1 chunk, using 64" << std::endl;
+    worldChunks = 64;
+  }
+  if (orcCount < 0) {
+    std::cout << "--orcs can't be negative, using 300" << std::endl;
+    orcCount = 300;
+  }
+
+  InitWindow(screenWidth, screenHeight, "Classy Clash");
+
+  Texture2D tileset = LoadTexture("./assets/IceTileset.png");
+  Texture2D knightIdle =
+      LoadTexture("./assets/characters/knight_idle_spritesheet.png");
+  Texture2D knightRun =
+      LoadTexture("./assets/characters/knight_run_spritesheet.png");
+  const int knightFrames = 6;
+  const float knightScale = 4.0;
+
+  const char *orcPath =
+      "./assets/Tiny RPG Character Asset Pack v1.03 -Free Soldier&Orc/"
+      "Characters(100x100)/Orc/Orc/Orc-Walk.png";
+  Texture2D orcWalk = LoadTexture(orcPath);
+  const int orcFrames = 8;
+  const float orcFrameSize = 100;
+  const float orcScale = 1.5;
+
+  // at most 3x2 chunks fit on the screen, twice that is enough to walk back
+  // and forth without rebuilding
+  TileWorld world;
+  world.init(tileset, worldChunks, worldChunks, 12);
+  generateWorld(world);
+
+  // start in the middle of the map, in a small clearing so we aren't stuck in
+  // a tree
+  int startX = world.getWidth() / 2;
+  int startY = world.getHeight() / 2;
+  for (int y = startY - 2; y <= startY + 2; y++) {
+    for (int x = startX - 2; x <= startX + 2; x++) {
+      world.setDecor(x, y, TILE_NONE);
+    }
+  }
+  Vector2 heroPos{(startX + 0.5f) * TILE_SIZE, (startY + 0.5f) * TILE_SIZE};
+  const float heroSpeed = 240;
+  float heroDirection = 1;
+  double elapsed = 0;
+
+  // orcs start scattered around the hero, on free tiles
+  std::vector<Orc> orcs;
+  orcs.reserve(orcCount);
+  const int spawnRadius = 40;
+  // a map with few free tiles around the hero gets fewer orcs, instead of
+  // looking for a spot forever
+  const int maxSpawnTries = orcCount * 20;
+  for (int tries = 0; tries < maxSpawnTries && (int)orcs.size() < orcCount;
+       tries++) {
+    int x = (int)(heroPos.x / TILE_SIZE) +
+            GetRandomValue(-spawnRadius, spawnRadius);
+    int y = (int)(heroPos.y / TILE_SIZE) +
+            GetRandomValue(-spawnRadius, spawnRadius);
+    if (!world.isWalkable(x, y)) {
+      continue;
+    }
+    Orc orc;
+    orc.position = Vector2{(x + 0.5f) * TILE_SIZE, (y + 0.5f) * TILE_SIZE};
+    orc.speed = GetRandomValue(90, 150);
+    orc.reach = GetRandomValue(20, 90);
+    orc.direction = 1;
+    orc.animationOffset = GetRandomValue(0, 100) / 100.0f;
+    orcs.push_back(orc);
+  }
+
+  // every orc steers with the same flow field towards the hero. the search
+  // covers 64 tiles around him, and visits at most 8192 tiles per frame
+  FlowField flowField;
+  flowField.init(&world, 64);
+  double flowFieldTime = 0;
+
+  Camera2D camera;
+  camera.offset = Vector2{screenWidth / 2.0f, screenHeight / 2.0f};
+  camera.target = heroPos;
+  camera.rotation = 0;
+  camera.zoom = 1;
 
   SetTargetFPS(60);
 
   // Main game loop
   while (!WindowShouldClose()) {
     // Update
+    float dT = GetFrameTime();
+    elapsed += dT;
+
+    Vector2 direction{0, 0};
+    if (IsKeyDown(KEY_A)) {
+      direction.x -= 1;
+    }
+    if (IsKeyDown(KEY_D)) {
+      direction.x += 1;
+    }
+    if (IsKeyDown(KEY_W)) {
+      direction.y -= 1;
+    }
+    if (IsKeyDown(KEY_S)) {
+      direction.y += 1;
+    }
+    bool moving = direction.x != 0 || direction.y != 0;
+    if (direction.x != 0) {
+      heroDirection = direction.x;
+    }
+
+    heroPos = moveAndCollide(world, heroPos,
+                             Vector2{direction.x * heroSpeed * dT,
+                                     direction.y * heroSpeed * dT});
+    // stay inside the map
+    const float maxX = world.getWidth() * TILE_SIZE - 1;
+    const float maxY = world.getHeight() * TILE_SIZE - 1;
+    heroPos.x = heroPos.x < 0 ? 0 : (heroPos.x > maxX ? maxX : heroPos.x);
+    heroPos.y = heroPos.y < 0 ? 0 : (heroPos.y > maxY ? maxY : heroPos.y);
+    camera.target = heroPos;
+
+    double flowFieldStart = GetTime();
+    flowField.setTarget(heroPos);
+    flowField.update(8192);
+    flowFieldTime = GetTime() - flowFieldStart;
+
+    for (Orc &orc : orcs) {
+      float dx = heroPos.x - orc.position.x;
+      float dy = heroPos.y - orc.position.y;
+      if (dx * dx + dy * dy < orc.reach * orc.reach) {
+        continue;
+      }
+      Vector2 steer = flowField.getDirection(orc.position, heroPos);
+      if (steer.x != 0) {
+        orc.direction = steer.x > 0 ? 1 : -1;
+      }
+      orc.position = moveAndCollide(world, orc.position,
+                                    Vector2{steer.x * orc.speed * dT,
+                                            steer.y * orc.speed * dT});
+    }
 
     // Draw
     BeginDrawing();
-    ClearBackground(RAYWHITE);
-    DrawText("Congrats! You created your first raylib window!", 190, 200, 20,
-             LIGHTGRAY);
+    ClearBackground(BLACK);
+
+    // has to happen before BeginMode2D, it may draw into chunk textures
+    world.update(camera);
+
+    BeginMode2D(camera);
+    world.draw();
+
+    // only the orcs on screen, with a sprite of margin
+    Vector2 viewMin = GetScreenToWorld2D(Vector2{0, 0}, camera);
+    Vector2 viewMax = GetScreenToWorld2D(
+        Vector2{(float)screenWidth, (float)screenHeight}, camera);
+    const float orcSize = orcFrameSize * orcScale;
+    int orcsDrawn = 0;
+    for (const Orc &orc : orcs) {
+      if (orc.position.x < viewMin.x - orcSize ||
+          orc.position.x > viewMax.x + orcSize ||
+          orc.position.y < viewMin.y - orcSize ||
+          orc.position.y > viewMax.y + orcSize) {
+        continue;
+      }
+      int frame = static_cast<int>((elapsed + orc.animationOffset) * 10) %
+                  orcFrames;
+      Rectangle src{frame * orcFrameSize, 0, orc.direction * orcFrameSize,
+                    orcFrameSize};
+      Rectangle dest{orc.position.x - orcSize / 2,
+                     orc.position.y - orcSize / 2, orcSize, orcSize};
+      DrawTexturePro(orcWalk, src, dest, Vector2{0, 0}, 0, WHITE);
+      orcsDrawn++;
+    }
+
+    Texture2D &knight = moving ? knightRun : knightIdle;
+    float frameSize = knight.width / knightFrames;
+    int frame = static_cast<int>(elapsed / (1.0 / 12)) % knightFrames;
+    // negative width flips the sprite when walking left
+    Rectangle src{frame * frameSize, 0, heroDirection * frameSize,
+                  (float)knight.height};
+    Rectangle dest{heroPos.x - frameSize * knightScale / 2,
+                   heroPos.y - knight.height * knightScale / 2,
+                   frameSize * knightScale, knight.height * knightScale};
+    DrawTexturePro(knight, src, dest, Vector2{0, 0}, 0, WHITE);
+    EndMode2D();
+
+    DrawRectangle(0, 0, 360, 50, Fade(BLACK, 0.6));
+    DrawText(TextFormat("chunks: %d visible, %d cached, %d rebuilt, %d total",
+                        world.getVisibleChunks(), world.getCacheSize(),
+                        world.getRebuiltChunks(), world.getChunkCount()),
+             8, 6, 10, WHITE);
+    DrawText(TextFormat("orcs: %d (%d drawn), flow field: %d tiles, %.2f ms",
+                        (int)orcs.size(), orcsDrawn,
+                        flowField.getLastVisited(), flowFieldTime * 1000),
+             8, 20, 10, WHITE);
+    DrawText(TextFormat("%d fps", GetFPS()), 8, 34, 10, WHITE);
+
     EndDrawing();
   }
 
   // De-Initialization
+  world.unload();
+  UnloadTexture(knightIdle);
+  UnloadTexture(knightRun);
+  UnloadTexture(orcWalk);
+  UnloadTexture(tileset);
   CloseWindow();
 
   return 0;
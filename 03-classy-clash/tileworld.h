@@ -0,0 +1,246 @@
+#ifndef tileworld_h
+#define tileworld_h
+
+#include "raylib.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// tiles of IceTileset.png, the index is row * TILESET_COLUMNS + column
+const int TILE_SIZE = 32;
+const int TILESET_COLUMNS = 20;
+
+const uint8_t TILE_NONE = 255;
+const uint8_t TILE_SNOW = 40;
+const uint8_t TILE_ICE = 41;
+const uint8_t TILE_STONE = 42;
+const uint8_t TILE_DARK_STONE = 43;
+const uint8_t TILE_SIGN = 2;
+const uint8_t TILE_LOG = 3;
+const uint8_t TILE_SMALL_TREE = 21;
+const uint8_t TILE_ROCK = 22;
+
+// a square of CHUNK_SIZE x CHUNK_SIZE tiles, the unit the world is stored,
+// cached and drawn in
+const int CHUNK_SIZE = 16;
+const int CHUNK_PIXELS = CHUNK_SIZE * TILE_SIZE;
+
+struct Chunk {
+  // ground is always drawn, decor (trees, rocks...) goes on top of it
+  std::array<uint8_t, CHUNK_SIZE * CHUNK_SIZE> ground;
+  std::array<uint8_t, CHUNK_SIZE * CHUNK_SIZE> decor;
+  // slot in the texture cache, -1 when the chunk isn't cached
+  int cacheSlot = -1;
+  // tiles changed since it was cached
+  bool dirty = true;
+};
+
+// a top-down tile map split in chunks.
+//
+// drawing the map tile by tile costs one draw per visible tile, every frame.
+// instead each visible chunk is drawn once into its own render texture and
+// after that the chunk is a single draw. only the chunks around the camera are
+// kept in the cache, so the cost of a frame depends on the screen size and not
+// on how big the map is: a chunk is only (re)built the frame it comes into view
+// (or when its tiles change), the cache slots of chunks that left the view are
+// reused for the ones coming in.
+class TileWorld {
+
+private:
+  int chunksX_{0};
+  int chunksY_{0};
+  std::vector<Chunk> chunks_;
+
+  Texture2D tileset_;
+
+  struct CacheSlot {
+    RenderTexture2D target;
+    // chunk using the slot, -1 when free
+    int chunk;
+    uint64_t lastVisibleFrame;
+  };
+  std::vector<CacheSlot> cache_;
+
+  uint64_t frame_{0};
+  // visible chunks, inclusive, set by update()
+  int firstX_{0}, firstY_{0}, lastX_{-1}, lastY_{-1};
+  int rebuiltChunks_{0};
+
+public:
+  // the size is in chunks. the cache needs enough slots for every chunk that
+  // can be on screen at once, plus some room so walking back and forth doesn't
+  // rebuild the same chunks
+  void init(Texture2D tileset, int chunksX, int chunksY, int cacheSlots) {
+    tileset_ = tileset;
+    chunksX_ = chunksX;
+    chunksY_ = chunksY;
+    chunks_.assign(chunksX * chunksY, Chunk());
+    for (Chunk &chunk : chunks_) {
+      chunk.ground.fill(TILE_SNOW);
+      chunk.decor.fill(TILE_NONE);
+    }
+
+    cache_.resize(cacheSlots);
+    for (CacheSlot &slot : cache_) {
+      slot.target = LoadRenderTexture(CHUNK_PIXELS, CHUNK_PIXELS);
+      slot.chunk = -1;
+      slot.lastVisibleFrame = 0;
+    }
+  }
+
+  void unload() {
+    for (CacheSlot &slot : cache_) {
+      UnloadRenderTexture(slot.target);
+    }
+    cache_.clear();
+  }
+
+  int getWidth() const { return chunksX_ * CHUNK_SIZE; }
+  int getHeight() const { return chunksY_ * CHUNK_SIZE; }
+
+  uint8_t getGround(int x, int y) const {
+    return chunkAt(x, y).ground[tileIndex(x, y)];
+  }
+  uint8_t getDecor(int x, int y) const {
+    return chunkAt(x, y).decor[tileIndex(x, y)];
+  }
+
+  // decor blocks the way, outside the map too
+  bool isWalkable(int x, int y) const {
+    return x >= 0 && y >= 0 && x < getWidth() && y < getHeight() &&
+           getDecor(x, y) == TILE_NONE;
+  }
+
+  void setGround(int x, int y, uint8_t tile) {
+    Chunk &chunk = chunkAt(x, y);
+    chunk.ground[tileIndex(x, y)] = tile;
+    chunk.dirty = true;
+  }
+  void setDecor(int x, int y, uint8_t tile) {
+    Chunk &chunk = chunkAt(x, y);
+    chunk.decor[tileIndex(x, y)] = tile;
+    chunk.dirty = true;
+  }
+
+  // finds the chunks the camera sees and builds the ones that need it. call it
+  // every frame before BeginMode2D, render textures can't be drawn into while
+  // in 2D mode
+  void update(const Camera2D &camera) {
+    frame_++;
+    rebuiltChunks_ = 0;
+
+    Vector2 topLeft = GetScreenToWorld2D(Vector2{0, 0}, camera);
+    Vector2 bottomRight = GetScreenToWorld2D(
+        Vector2{(float)GetScreenWidth(), (float)GetScreenHeight()}, camera);
+    firstX_ = clamp((int)(topLeft.x / CHUNK_PIXELS), 0, chunksX_ - 1);
+    firstY_ = clamp((int)(topLeft.y / CHUNK_PIXELS), 0, chunksY_ - 1);
+    lastX_ = clamp((int)(bottomRight.x / CHUNK_PIXELS), 0, chunksX_ - 1);
+    lastY_ = clamp((int)(bottomRight.y / CHUNK_PIXELS), 0, chunksY_ - 1);
+
+    for (int cy = firstY_; cy <= lastY_; cy++) {
+      for (int cx = firstX_; cx <= lastX_; cx++) {
+        prepare(cy * chunksX_ + cx);
+      }
+    }
+  }
+
+  // one draw per visible chunk, call between BeginMode2D/EndMode2D
+  void draw() const {
+    for (int cy = firstY_; cy <= lastY_; cy++) {
+      for (int cx = firstX_; cx <= lastX_; cx++) {
+        const Chunk &chunk = chunks_[cy * chunksX_ + cx];
+        // render textures are upside down in OpenGL, the negative height
+        // flips them back
+        DrawTextureRec(cache_[chunk.cacheSlot].target.texture,
+                       Rectangle{0, 0, CHUNK_PIXELS, -CHUNK_PIXELS},
+                       Vector2{(float)cx * CHUNK_PIXELS,
+                               (float)cy * CHUNK_PIXELS},
+                       WHITE);
+      }
+    }
+  }
+
+  int getChunkCount() const { return chunks_.size(); }
+  int getVisibleChunks() const {
+    return (lastX_ - firstX_ + 1) * (lastY_ - firstY_ + 1);
+  }
+  int getRebuiltChunks() const { return rebuiltChunks_; }
+  int getCacheSize() const { return cache_.size(); }
+
+private:
+  static int clamp(int value, int min, int max) {
+    return value < min ? min : (value > max ? max : value);
+  }
+
+  Chunk &chunkAt(int x, int y) {
+    return chunks_[(y / CHUNK_SIZE) * chunksX_ + x / CHUNK_SIZE];
+  }
+  const Chunk &chunkAt(int x, int y) const {
+    return chunks_[(y / CHUNK_SIZE) * chunksX_ + x / CHUNK_SIZE];
+  }
+  static int tileIndex(int x, int y) {
+    return (y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE;
+  }
+
+  // makes sure the chunk has an up to date cached texture
+  void prepare(int index) {
+    Chunk &chunk = chunks_[index];
+
+    if (chunk.cacheSlot == -1) {
+      chunk.cacheSlot = findSlot();
+      CacheSlot &slot = cache_[chunk.cacheSlot];
+      if (slot.chunk != -1) {
+        chunks_[slot.chunk].cacheSlot = -1;
+      }
+      slot.chunk = index;
+      chunk.dirty = true;
+    }
+
+    cache_[chunk.cacheSlot].lastVisibleFrame = frame_;
+    if (chunk.dirty) {
+      build(chunk);
+    }
+  }
+
+  // a free slot, otherwise the one that has been out of view the longest
+  int findSlot() const {
+    int oldest = 0;
+    for (int i = 0; i < (int)cache_.size(); i++) {
+      if (cache_[i].chunk == -1) {
+        return i;
+      }
+      if (cache_[i].lastVisibleFrame < cache_[oldest].lastVisibleFrame) {
+        oldest = i;
+      }
+    }
+    // 🚨 if this one is visible too the cache is too small for the screen
+    return oldest;
+  }
+
+  void build(Chunk &chunk) {
+    BeginTextureMode(cache_[chunk.cacheSlot].target);
+    ClearBackground(BLANK);
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+      for (int x = 0; x < CHUNK_SIZE; x++) {
+        Vector2 position{(float)x * TILE_SIZE, (float)y * TILE_SIZE};
+        drawTile(chunk.ground[y * CHUNK_SIZE + x], position);
+        drawTile(chunk.decor[y * CHUNK_SIZE + x], position);
+      }
+    }
+    EndTextureMode();
+    chunk.dirty = false;
+    rebuiltChunks_++;
+  }
+
+  void drawTile(uint8_t tile, Vector2 position) {
+    if (tile == TILE_NONE) {
+      return;
+    }
+    Rectangle src{(float)(tile % TILESET_COLUMNS) * TILE_SIZE,
+                  (float)(tile / TILESET_COLUMNS) * TILE_SIZE, TILE_SIZE,
+                  TILE_SIZE};
+    DrawTextureRec(tileset_, src, position, WHITE);
+  }
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "alloctracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// counters of the frame being played, atomic because SDL may call into our code from
+// its own threads
+static std::atomic<uint64_t> currentAllocations[ALLOC_TAG_COUNT];
+static std::atomic<uint64_t> currentBytes[ALLOC_TAG_COUNT];
+
+static AllocCounters previousFrame[ALLOC_TAG_COUNT];
+
+// each thread tags its own allocations
+static thread_local AllocTag currentTag = AllocTag::OTHER;
+
+static void *trackedAlloc(std::size_t size) {
+    int tag = static_cast<int>(currentTag);
+    currentAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+    currentBytes[tag].fetch_add(size, std::memory_order_relaxed);
+
+    // malloc(0) may return NULL, but new must always return a unique pointer
+    return std::malloc(size ? size : 1);
+}
+
+// for types with alignas() bigger than what malloc guarantees
+static void *trackedAlignedAlloc(std::size_t size, std::align_val_t align) {
+    int tag = static_cast<int>(currentTag);
+    currentAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+    currentBytes[tag].fetch_add(size, std::memory_order_relaxed);
+
+    // aligned_alloc wants the size to be a multiple of the alignment
+    std::size_t alignment = static_cast<std::size_t>(align);
+    std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, rounded ? rounded : alignment);
+}
+
+void AllocTracker::beginFrame() {
+    for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+        previousFrame[i].allocations = currentAllocations[i].exchange(0);
+        previousFrame[i].bytes = currentBytes[i].exchange(0);
+    }
+}
+
+AllocCounters AllocTracker::lastFrame(AllocTag tag) {
+    return previousFrame[static_cast<int>(tag)];
+}
+
+AllocCounters AllocTracker::lastFrameTotal() {
+    AllocCounters total;
+    for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+        total.allocations += previousFrame[i].allocations;
+        total.bytes += previousFrame[i].bytes;
+    }
+    return total;
+}
+
+AllocTag AllocTracker::getTag() { return currentTag; }
+void AllocTracker::setTag(AllocTag tag) { currentTag = tag; }
+
+const char *AllocTracker::getTagName(AllocTag tag) {
+    switch (tag) {
+    case AllocTag::OTHER:
+        return "other";
+    case AllocTag::INPUT:
+        return "input";
+    case AllocTag::UPDATE:
+        return "update";
+    case AllocTag::SHOOTING:
+        return "shooting";
+    case AllocTag::DRAW:
+        return "draw";
+    case AllocTag::COUNT:
+        break;
+    }
+    return "unknown";
+}
+
+// 💡 replacing these four (plus the nothrow versions) replaces every `new` and `delete`
+// of the program, including the ones made by std::vector and std::string
+void *operator new(std::size_t size) {
+    void *ptr = trackedAlloc(size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return trackedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return trackedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+// since C++14 the compiler may call the sized versions instead
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+// the aligned versions, otherwise over-aligned types would escape the counters
+void *operator new(std::size_t size, std::align_val_t align) {
+    void *ptr = trackedAlignedAlloc(size, align);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void *operator new(
+    std::size_t size,
+    std::align_val_t align,
+    const std::nothrow_t &) noexcept {
+    return trackedAlignedAlloc(size, align);
+}
+
+void *operator new[](
+    std::size_t size,
+    std::align_val_t align,
+    const std::nothrow_t &) noexcept {
+    return trackedAlignedAlloc(size, align);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
@@ -0,0 +1,33 @@
+#ifndef alloctracker_h
+#define alloctracker_h
+
+#include <cstdint>
+
+// which part of the frame made the allocation, set by the FrameProfiler (profiler.h)
+enum class AllocTag { OTHER, INPUT, UPDATE, SHOOTING, DRAW, COUNT };
+
+const int ALLOC_TAG_COUNT = static_cast<int>(AllocTag::COUNT);
+
+struct AllocCounters {
+    uint64_t allocations;
+    uint64_t bytes;
+    AllocCounters() : allocations(0), bytes(0) {}
+};
+
+// counts every `new` made by our code (global operator new is replaced in
+// alloctracker.cpp). SDL allocates through malloc so its allocations aren't counted
+class AllocTracker {
+  public:
+    // closes the current frame, its counters become available through lastFrame()
+    static void beginFrame();
+
+    static AllocCounters lastFrame(AllocTag tag);
+    static AllocCounters lastFrameTotal();
+
+    static AllocTag getTag();
+    static void setTag(AllocTag tag);
+
+    static const char *getTagName(AllocTag tag);
+};
+
+#endif
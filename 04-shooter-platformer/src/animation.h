@@ -1,24 +1,22 @@
 #ifndef animation_h
 #define animation_h
 
-#include "timer.h"
-
+// describes a clip of a sprite sheet, the playback itself (time, current frame) lives in
+// the AnimationSystem
 class Animation {
-    Timer timer;
     int frameCount;
+    float duration;
+    // frames are square, laid out horizontally in the sprite sheet
+    float frameSize;
 
   public:
-    Animation() : timer(Timer(0)), frameCount(0) {}
-    Animation(int frameCount, float duration) : timer(duration), frameCount(frameCount) {}
-
-    float getLength() const { return timer.getDuration(); }
-
-    int currentFrame() const {
-        return static_cast<int>(timer.getTime() / timer.getDuration() * frameCount);
-    }
-    void step(float deltaTime) { timer.step(deltaTime); }
+    Animation() : frameCount(0), duration(0), frameSize(0) {}
+    Animation(int count, float length, float size)
+        : frameCount(count), duration(length), frameSize(size) {}
 
-    bool isDone() const { return timer.isTimeout(); }
+    int getFrameCount() const { return frameCount; }
+    float getLength() const { return duration; }
+    float getFrameSize() const { return frameSize; }
 };
 
 #endif
@@ -0,0 +1,159 @@
+#ifndef animationsystem_h
+#define animationsystem_h
+
+#include "SDL3/SDL_rect.h"
+#include "animation.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// advances every animation of the game in a single pass. instead of each object owning
+// and stepping its own animations, objects own a handle to a playback slot, and the state
+// of all playbacks is stored packed in arrays (one array per field), so update() is a
+// few tight loops the compiler can vectorize.
+//
+// after update() the frame index and the source rect of every playback are ready, the
+// draw pass only reads them
+class AnimationSystem {
+    // inputs, set by play()/stop()
+    std::vector<float> times;
+    std::vector<float> durations;
+    // frameCount / duration, saves us a division per playback per frame
+    std::vector<float> framesPerSecond;
+    std::vector<float> lastFrames;
+    std::vector<float> frameSizes;
+    // 1 when playing and 0 when stopped, a float so it can multiply the delta time
+    std::vector<float> playing;
+
+    // outputs
+    // 1 once the clip played through at least once
+    std::vector<float> done;
+    std::vector<int> frames;
+    std::vector<SDL_FRect> srcRects;
+
+  public:
+    void reserve(size_t count) {
+        times.reserve(count);
+        durations.reserve(count);
+        framesPerSecond.reserve(count);
+        lastFrames.reserve(count);
+        frameSizes.reserve(count);
+        playing.reserve(count);
+        done.reserve(count);
+        frames.reserve(count);
+        srcRects.reserve(count);
+    }
+
+    // returns the handle of a new (stopped) playback
+    int create() {
+        times.push_back(0);
+        durations.push_back(0);
+        framesPerSecond.push_back(0);
+        lastFrames.push_back(0);
+        frameSizes.push_back(0);
+        playing.push_back(0);
+        done.push_back(0);
+        frames.push_back(0);
+        srcRects.push_back(SDL_FRect{0, 0, 0, 0});
+        return static_cast<int>(times.size()) - 1;
+    }
+
+    // starts the clip from its first frame
+    void play(int handle, const Animation &clip) {
+        times[handle] = 0;
+        durations[handle] = clip.getLength();
+        framesPerSecond[handle] =
+            clip.getLength() > 0 ? clip.getFrameCount() / clip.getLength() : 0;
+        lastFrames[handle] = static_cast<float>(clip.getFrameCount() - 1);
+        frameSizes[handle] = clip.getFrameSize();
+        playing[handle] = clip.getLength() > 0 ? 1.0f : 0.0f;
+        done[handle] = 0;
+        setFrame(handle, 0);
+    }
+
+    // freezes the playback on a specific frame of the last played clip
+    void stop(int handle, int frame) {
+        playing[handle] = 0;
+        setFrame(handle, frame);
+    }
+
+    void update(float deltaTime) {
+        const size_t count = times.size();
+        float *time = times.data();
+        const float *duration = durations.data();
+        const float *fps = framesPerSecond.data();
+        const float *lastFrame = lastFrames.data();
+        const float *frameSize = frameSizes.data();
+        const float *isPlaying = playing.data();
+        float *isDone = done.data();
+        int *frame = frames.data();
+
+        // 💡 no branches in the loop bodies, conditions become multiplications by 0 or 1
+        // so every iteration does the same work, which is what lets them vectorize
+        for (size_t i = 0; i < count; i++) {
+            time[i] += deltaTime * isPlaying[i];
+
+            // we don't reset the time to 0 when the clip loops, we keep the leftover,
+            // or the few microseconds past the end of the clip would be lost
+            float looped = (time[i] >= duration[i]) * isPlaying[i];
+            time[i] -= looped * duration[i];
+            isDone[i] = std::max(isDone[i], looped);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            // stopped playbacks keep the frame they were frozen on
+            float current = time[i] * fps[i] * isPlaying[i] +
+                            static_cast<float>(frame[i]) * (1.0f - isPlaying[i]);
+            // float rounding could land exactly on frameCount
+            frame[i] = static_cast<int>(std::min(current, lastFrame[i]));
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            srcRects[i].x = frame[i] * frameSize[i];
+            srcRects[i].y = 0;
+            srcRects[i].w = frameSize[i];
+            srcRects[i].h = frameSize[i];
+        }
+    }
+
+    // every playback, see snapshot.h
+    void save(Snapshot &snapshot) const {
+        snapshot.writeVector(times);
+        snapshot.writeVector(durations);
+        snapshot.writeVector(framesPerSecond);
+        snapshot.writeVector(lastFrames);
+        snapshot.writeVector(frameSizes);
+        snapshot.writeVector(playing);
+        snapshot.writeVector(done);
+        snapshot.writeVector(frames);
+        snapshot.writeVector(srcRects);
+    }
+
+    void restore(Snapshot &snapshot) {
+        snapshot.readVector(times);
+        snapshot.readVector(durations);
+        snapshot.readVector(framesPerSecond);
+        snapshot.readVector(lastFrames);
+        snapshot.readVector(frameSizes);
+        snapshot.readVector(playing);
+        snapshot.readVector(done);
+        snapshot.readVector(frames);
+        snapshot.readVector(srcRects);
+    }
+
+    int getFrame(int handle) const { return frames[handle]; }
+    bool isDone(int handle) const { return done[handle] > 0; }
+    const SDL_FRect &getSrcRect(int handle) const { return srcRects[handle]; }
+    size_t size() const { return times.size(); }
+
+  private:
+    void setFrame(int handle, int frame) {
+        frames[handle] = frame;
+        srcRects[handle] =
+            SDL_FRect{
+                frame * frameSizes[handle], 0, frameSizes[handle], frameSizes[handle]};
+    }
+};
+
+#endif
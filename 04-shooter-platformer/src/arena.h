@@ -0,0 +1,114 @@
+#ifndef arena_h
+#define arena_h
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// bump allocator for data that only lives during a single frame. allocating is moving a
+// pointer forward, freeing does nothing, and everything is released at once by reset()
+// at the start of the next frame
+class FrameArena {
+    // what didn't fit in the buffer goes to the heap in blocks chained together, so
+    // reset() can release them too
+    struct alignas(std::max_align_t) OverflowBlock {
+        OverflowBlock *next;
+    };
+
+    char *buffer;
+    size_t capacity;
+    size_t offset;
+    // highest offset ever reached, tells us how big the arena really needs to be
+    size_t peak;
+    // bytes that didn't fit this frame and went to the heap instead, should stay at 0
+    size_t overflow;
+    OverflowBlock *overflowBlocks;
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+  public:
+    explicit FrameArena(size_t size)
+        : buffer(new char[size]), capacity(size), offset(0), peak(0), overflow(0),
+          overflowBlocks(NULL) {}
+    ~FrameArena() {
+        reset();
+        delete[] buffer;
+    }
+
+    void *allocate(size_t size, size_t alignment) {
+        // round the offset up to the next multiple of the alignment (always a power of 2)
+        uintptr_t current = reinterpret_cast<uintptr_t>(buffer) + offset;
+        uintptr_t aligned = (current + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t newOffset = aligned - reinterpret_cast<uintptr_t>(buffer) + size;
+
+        if (newOffset > capacity) {
+            // ⚠️ out of space, better slow than crashing. it shows up in the debug
+            // overlay so we know the arena needs to grow
+            overflow += size;
+            void *memory = ::operator new(sizeof(OverflowBlock) + size);
+            OverflowBlock *block = static_cast<OverflowBlock *>(memory);
+            block->next = overflowBlocks;
+            overflowBlocks = block;
+            return block + 1;
+        }
+
+        offset = newOffset;
+        if (offset > peak) {
+            peak = offset;
+        }
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    // everything, overflow included, is released by reset()
+    void deallocate(void *) {}
+
+    // 🚨 everything allocated before is invalid after this call
+    void reset() {
+        while (overflowBlocks) {
+            OverflowBlock *next = overflowBlocks->next;
+            ::operator delete(overflowBlocks);
+            overflowBlocks = next;
+        }
+        offset = 0;
+        overflow = 0;
+    }
+
+    size_t getUsed() const { return offset; }
+    size_t getPeak() const { return peak; }
+    size_t getCapacity() const { return capacity; }
+    size_t getOverflow() const { return overflow; }
+};
+
+// lets standard containers allocate from a FrameArena, e.g.
+// std::vector<int, ArenaAllocator<int>> list((ArenaAllocator<int>(arena)));
+template <typename T>
+class ArenaAllocator {
+  public:
+    typedef T value_type;
+
+    FrameArena *arena;
+
+    explicit ArenaAllocator(FrameArena &frameArena) : arena(&frameArena) {}
+
+    // containers rebind the allocator to their internal types (e.g. list nodes)
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *ptr, size_t) { arena->deallocate(ptr); }
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+    return a.arena != b.arena;
+}
+
+#endif
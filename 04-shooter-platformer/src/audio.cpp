@@ -0,0 +1,294 @@
+#include "SDL3/SDL_init.h"
+#include "SDL3/SDL_timer.h"
+#include "audio.h"
+#include <cmath>
+#include <iostream>
+
+AudioEngine::AudioEngine()
+    : stream(NULL), thread(NULL), running(false), droppedCommands(0), muted(false),
+      masterVolume(1.0f), underruns(0), blocksMixed(0), mixTimeTotalNs(0),
+      mixTimePeakNs(0), activeVoices(0) {
+    for (int i = 0; i < MAX_VOICES; i++) {
+        voices[i].clip = AudioClip::COUNT;
+        voices[i].startedAt = 0;
+        voices[i].active = false;
+    }
+}
+
+AudioEngine::~AudioEngine() { shutdown(); }
+
+bool AudioEngine::init() {
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        std::cerr << "Audio disabled, SDL_InitSubSystem failed: " << SDL_GetError()
+                  << std::endl;
+        return false;
+    }
+
+    SDL_AudioSpec spec;
+    spec.format = SDL_AUDIO_F32;
+    spec.channels = 2;
+    spec.freq = SAMPLE_RATE;
+
+    // no callback, we push data into the stream from our own thread. SDL converts it to
+    // whatever the device wants
+    stream =
+        SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, NULL, NULL);
+    if (!stream) {
+        std::cerr << "Audio disabled, SDL_OpenAudioDeviceStream failed: "
+                  << SDL_GetError() << std::endl;
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    synthesizeClips();
+
+    running = true;
+    thread = SDL_CreateThread(mixThread, "audio mixer", this);
+    if (!thread) {
+        std::cerr << "Audio disabled, SDL_CreateThread failed: " << SDL_GetError()
+                  << std::endl;
+        running = false;
+        SDL_DestroyAudioStream(stream);
+        stream = NULL;
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    // devices opened with SDL_OpenAudioDeviceStream start paused
+    SDL_ResumeAudioStreamDevice(stream);
+    return true;
+}
+
+void AudioEngine::shutdown() {
+    if (!stream) {
+        return;
+    }
+    running = false;
+    SDL_WaitThread(thread, NULL);
+    thread = NULL;
+    SDL_DestroyAudioStream(stream);
+    stream = NULL;
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+void AudioEngine::play(AudioClip clip, float volume, float pan) {
+    AudioCommand command;
+    command.type = AudioCommand::PLAY;
+    command.clip = clip;
+    command.volume = volume;
+    command.pan = pan < -1.0f ? -1.0f : (pan > 1.0f ? 1.0f : pan);
+    push(command);
+}
+
+void AudioEngine::stop(AudioClip clip) {
+    AudioCommand command;
+    command.type = AudioCommand::STOP;
+    command.clip = clip;
+    command.volume = 0;
+    command.pan = 0;
+    push(command);
+}
+
+void AudioEngine::setMasterVolume(float volume) {
+    AudioCommand command;
+    command.type = AudioCommand::SET_VOLUME;
+    command.clip = AudioClip::COUNT;
+    command.volume = volume;
+    command.pan = 0;
+    push(command);
+}
+
+void AudioEngine::push(const AudioCommand &command) {
+    if (!stream || muted) {
+        return;
+    }
+    // ⚠️ never wait for the mixer, a lost sound is better than a stalled frame
+    if (!commands.push(command)) {
+        droppedCommands++;
+    }
+}
+
+AudioStats AudioEngine::getStats() const {
+    AudioStats stats;
+    uint64_t blocks = blocksMixed.load(std::memory_order_relaxed);
+    stats.blocksMixed = blocks;
+    stats.mixTimeAvgUs =
+        blocks ? mixTimeTotalNs.load(std::memory_order_relaxed) / 1000.0 / blocks : 0;
+    stats.mixTimePeakUs = mixTimePeakNs.load(std::memory_order_relaxed) / 1000.0;
+    stats.underruns = underruns.load(std::memory_order_relaxed);
+    stats.droppedCommands = droppedCommands;
+    stats.activeVoices = activeVoices.load(std::memory_order_relaxed);
+    return stats;
+}
+
+int SDLCALL AudioEngine::mixThread(void *data) {
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+    static_cast<AudioEngine *>(data)->mixLoop();
+    return 0;
+}
+
+void AudioEngine::mixLoop() {
+    const int blockBytes = BLOCK_FRAMES * 2 * sizeof(float);
+    bool started = false;
+
+    while (running.load(std::memory_order_acquire)) {
+        AudioCommand command;
+        while (commands.pop(command)) {
+            runCommand(command);
+        }
+
+        int queued = SDL_GetAudioStreamQueued(stream);
+        if (started && queued == 0) {
+            // the device ate everything we gave it, it's playing silence right now
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        while (queued < BLOCKS_AHEAD * blockBytes) {
+            uint64_t mixStart = SDL_GetTicksNS();
+            mixBlock();
+            SDL_PutAudioStreamData(stream, mixBuffer, blockBytes);
+            queued += blockBytes;
+            started = true;
+
+            uint64_t mixTime = SDL_GetTicksNS() - mixStart;
+            blocksMixed.fetch_add(1, std::memory_order_relaxed);
+            mixTimeTotalNs.fetch_add(mixTime, std::memory_order_relaxed);
+            if (mixTime > mixTimePeakNs.load(std::memory_order_relaxed)) {
+                mixTimePeakNs.store(mixTime, std::memory_order_relaxed);
+            }
+        }
+
+        // a block is ~5ms, waking up every ms gives plenty of room to refill
+        SDL_DelayNS(SDL_NS_PER_MS);
+    }
+}
+
+void AudioEngine::runCommand(const AudioCommand &command) {
+    switch (command.type) {
+    case AudioCommand::PLAY: {
+        // a free voice, or steal the one that has been playing for the longest
+        Voice *voice = &voices[0];
+        for (int i = 0; i < MAX_VOICES; i++) {
+            if (!voices[i].active) {
+                voice = &voices[i];
+                break;
+            }
+            if (voices[i].startedAt < voice->startedAt) {
+                voice = &voices[i];
+            }
+        }
+        voice->samples = &clips[static_cast<int>(command.clip)];
+        voice->clip = command.clip;
+        voice->position = 0;
+        // simple linear panning, the center plays at full volume on both sides
+        voice->left = command.volume * (command.pan > 0 ? 1.0f - command.pan : 1.0f);
+        voice->right = command.volume * (command.pan < 0 ? 1.0f + command.pan : 1.0f);
+        voice->startedAt = blocksMixed.load(std::memory_order_relaxed);
+        voice->active = true;
+        break;
+    }
+    case AudioCommand::STOP: {
+        for (int i = 0; i < MAX_VOICES; i++) {
+            if (voices[i].clip == command.clip) {
+                voices[i].active = false;
+            }
+        }
+        break;
+    }
+    case AudioCommand::SET_VOLUME: {
+        masterVolume = command.volume;
+        break;
+    }
+    }
+}
+
+void AudioEngine::mixBlock() {
+    for (int i = 0; i < BLOCK_FRAMES * 2; i++) {
+        mixBuffer[i] = 0;
+    }
+
+    int active = 0;
+    for (int v = 0; v < MAX_VOICES; v++) {
+        Voice &voice = voices[v];
+        if (!voice.active) {
+            continue;
+        }
+
+        const std::vector<float> &samples = *voice.samples;
+        size_t remaining = samples.size() - voice.position;
+        int frames =
+            remaining < BLOCK_FRAMES ? static_cast<int>(remaining) : BLOCK_FRAMES;
+
+        const float *in = &samples[voice.position];
+        for (int i = 0; i < frames; i++) {
+            mixBuffer[i * 2] += in[i] * voice.left;
+            mixBuffer[i * 2 + 1] += in[i] * voice.right;
+        }
+
+        voice.position += frames;
+        if (voice.position >= samples.size()) {
+            voice.active = false;
+        } else {
+            active++;
+        }
+    }
+    activeVoices.store(active, std::memory_order_relaxed);
+
+    // a few loud voices together go over 1, clip instead of wrapping around
+    for (int i = 0; i < BLOCK_FRAMES * 2; i++) {
+        float sample = mixBuffer[i] * masterVolume;
+        mixBuffer[i] = sample < -1.0f ? -1.0f : (sample > 1.0f ? 1.0f : sample);
+    }
+}
+
+// how a clip is synthesized: a wave sliding from startHz to endHz mixed with some noise,
+// fading out at `decay` per second
+struct ClipShape {
+    float length;
+    float startHz, endHz;
+    float noise;
+    float decay;
+    bool square;
+};
+
+// in AudioClip order
+static const ClipShape CLIP_SHAPES[AUDIO_CLIP_COUNT] = {
+    {0.15f, 900, 150, 0.2f, 20, true},  // SHOOT
+    {0.08f, 200, 100, 0.8f, 40, false}, // BULLET_HIT
+    {0.2f, 180, 60, 0.3f, 15, false},   // ENEMY_HIT
+    {0.6f, 400, 40, 0.1f, 4, true},     // ENEMY_DEATH
+};
+
+// the clips are made out of simple waves with a volume envelope, like old consoles did.
+// noise comes from a tiny LCG so every run sounds the same
+void AudioEngine::synthesizeClips() {
+    const float PI = 3.14159265f;
+    uint32_t seed = 12345;
+
+    for (int c = 0; c < AUDIO_CLIP_COUNT; c++) {
+        const ClipShape &shape = CLIP_SHAPES[c];
+        const float length = shape.length;
+
+        std::vector<float> &samples = clips[c];
+        samples.resize(static_cast<size_t>(length * SAMPLE_RATE));
+
+        float phase = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            float t = static_cast<float>(i) / SAMPLE_RATE;
+            float progress = t / length;
+            // exponential pitch slide sounds more natural than a linear one
+            float hz = shape.startHz * std::pow(shape.endHz / shape.startHz, progress);
+            phase += hz / SAMPLE_RATE;
+            phase -= std::floor(phase);
+
+            float tone =
+                shape.square ? (phase < 0.5f ? 1.0f : -1.0f) : std::sin(phase * 2 * PI);
+            seed = seed * 1664525u + 1013904223u;
+            float white = static_cast<float>(seed >> 8) / (1 << 24) * 2 - 1;
+
+            float envelope = std::exp(-shape.decay * t);
+            samples[i] =
+                0.4f * envelope * (tone * (1 - shape.noise) + white * shape.noise);
+        }
+    }
+}
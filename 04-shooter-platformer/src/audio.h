@@ -0,0 +1,113 @@
+#ifndef audio_h
+#define audio_h
+
+#include "SDL3/SDL_audio.h"
+#include "SDL3/SDL_thread.h"
+#include "spscqueue.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class AudioClip { SHOOT, BULLET_HIT, ENEMY_HIT, ENEMY_DEATH, COUNT };
+
+const int AUDIO_CLIP_COUNT = static_cast<int>(AudioClip::COUNT);
+
+// what the game asks the mixer to do, copied through the command queue
+struct AudioCommand {
+    enum Type { PLAY, STOP, SET_VOLUME };
+    Type type;
+    AudioClip clip;
+    float volume;
+    // -1 is all the way left, 1 all the way right
+    float pan;
+};
+
+struct AudioStats {
+    // how long mixing a block takes, a block is BLOCK_FRAMES of audio (~5ms)
+    double mixTimeAvgUs;
+    double mixTimePeakUs;
+    // times the device ran out of audio because we didn't mix in time, you hear a pop
+    uint64_t underruns;
+    uint64_t blocksMixed;
+    // commands lost because the queue was full
+    uint64_t droppedCommands;
+    int activeVoices;
+};
+
+// plays sounds on its own thread so mixing never costs frame time.
+//
+// the game thread only pushes commands into a lock-free queue (play, stop, volume), the
+// mixer thread takes them out, mixes every playing voice into a block and puts it in an
+// SDL audio stream, keeping a few blocks queued ahead of the device. all the clips are
+// decoded (well, synthesized, we have no audio files yet) into float samples in init(),
+// nothing is loaded or allocated while playing.
+class AudioEngine {
+  public:
+    static const int SAMPLE_RATE = 48000;
+    static const int BLOCK_FRAMES = 256;
+    // blocks kept queued in the stream, more is safer but adds latency (~16ms now)
+    static const int BLOCKS_AHEAD = 3;
+    static const int MAX_VOICES = 16;
+
+    AudioEngine();
+    ~AudioEngine();
+
+    // opens the default device and starts the mixer thread. when it fails the game runs
+    // without sound, every call below does nothing
+    bool init();
+    void shutdown();
+
+    // game thread only
+    void play(AudioClip clip, float volume = 1.0f, float pan = 0.0f);
+    void stop(AudioClip clip);
+    void setMasterVolume(float volume);
+    // while muted play() does nothing, used when replaying frames that already made
+    // their sounds
+    void setMuted(bool mute) { muted = mute; }
+
+    AudioStats getStats() const;
+
+  private:
+    struct Voice {
+        const std::vector<float> *samples;
+        AudioClip clip;
+        size_t position;
+        float left, right;
+        // block it started in, the oldest one is stolen when all voices are busy
+        uint64_t startedAt;
+        bool active;
+    };
+
+    SDL_AudioStream *stream;
+    SDL_Thread *thread;
+    std::atomic<bool> running;
+
+    SpscQueue<AudioCommand, 256> commands;
+    // written only by the game thread
+    uint64_t droppedCommands;
+    bool muted;
+
+    // mono float samples at SAMPLE_RATE
+    std::vector<float> clips[AUDIO_CLIP_COUNT];
+
+    // everything below is owned by the mixer thread
+    Voice voices[MAX_VOICES];
+    float masterVolume;
+    float mixBuffer[BLOCK_FRAMES * 2];
+
+    std::atomic<uint64_t> underruns;
+    std::atomic<uint64_t> blocksMixed;
+    std::atomic<uint64_t> mixTimeTotalNs;
+    std::atomic<uint64_t> mixTimePeakNs;
+    std::atomic<int> activeVoices;
+
+    void synthesizeClips();
+    void push(const AudioCommand &command);
+
+    static int SDLCALL mixThread(void *data);
+    void mixLoop();
+    void runCommand(const AudioCommand &command);
+    void mixBlock();
+};
+
+#endif
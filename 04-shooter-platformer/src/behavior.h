@@ -0,0 +1,323 @@
+#ifndef behavior_h
+#define behavior_h
+
+#include "timingwheel.h"
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <vector>
+
+// AI written as coroutines: a behavior is a function that runs like a script, and every
+// `co_await` pauses it until something happens ("wait 0.5s", "until the player is
+// close"...). while it waits it costs nothing, the BehaviorScheduler only resumes the
+// behaviors whose wait is over.
+//
+//     Behavior guard(GameState &gs, int index) {
+//         for (;;) {
+//             co_await gs.behaviors.until(index, isPlayerNear, &gs, 200);
+//             ...
+//             co_await gs.behaviors.sleep(index, timer, 0.5f);
+//         }
+//     }
+
+// 💡 coroutine frames are allocated by the compiler, these reuse the frames of finished
+// behaviors instead of going to the heap, so restarting a behavior (an enemy gets hit)
+// doesn't allocate in the middle of a frame
+struct alignas(16) BehaviorFrame {
+    BehaviorFrame *next;
+    std::size_t size;
+};
+
+inline BehaviorFrame *freeBehaviorFrames = NULL;
+
+inline void *allocateBehaviorFrame(std::size_t size) {
+    for (BehaviorFrame **link = &freeBehaviorFrames; *link; link = &(*link)->next) {
+        if ((*link)->size >= size) {
+            BehaviorFrame *frame = *link;
+            *link = frame->next;
+            return frame + 1;
+        }
+    }
+    BehaviorFrame *frame =
+        static_cast<BehaviorFrame *>(::operator new(sizeof(BehaviorFrame) + size));
+    frame->size = size;
+    return frame + 1;
+}
+
+inline void freeBehaviorFrame(void *ptr) {
+    BehaviorFrame *frame = static_cast<BehaviorFrame *>(ptr) - 1;
+    frame->next = freeBehaviorFrames;
+    freeBehaviorFrames = frame;
+}
+
+// what a coroutine returns to be a behavior, it owns the coroutine until it's given to
+// BehaviorScheduler::start()
+class Behavior {
+  public:
+    struct promise_type {
+        Behavior get_return_object() {
+            return Behavior(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        // doesn't run until the scheduler resumes it, see BehaviorScheduler::start()
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        // stays around once finished, the scheduler is the one destroying it
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        // ⚠️ the game doesn't use exceptions, a behavior throwing is a bug
+        void unhandled_exception() { std::terminate(); }
+
+        static void *operator new(std::size_t size) {
+            return allocateBehaviorFrame(size);
+        }
+        static void operator delete(void *ptr) { freeBehaviorFrame(ptr); }
+    };
+
+    Behavior(const Behavior &) = delete;
+    Behavior &operator=(const Behavior &) = delete;
+    Behavior(Behavior &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    ~Behavior() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    // the caller owns the coroutine now
+    std::coroutine_handle<> release() {
+        std::coroutine_handle<> released = handle;
+        handle = nullptr;
+        return released;
+    }
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Behavior(std::coroutine_handle<promise_type> h) : handle(h) {}
+};
+
+// a condition a behavior can wait for, checked once per frame while something waits on
+// it. `context` and `param` are whatever was given to until(), like TimerCallback
+typedef bool (*BehaviorCondition)(void *context, int index, float param);
+
+// runs one behavior per slot (the index of an object). every frame run() resumes the
+// behaviors that have something to do:
+// - nextFrame(): every frame, e.g. while steering
+// - sleep(): when its timer fires. the timers are in the TimingWheel, a sleeping
+//   behavior isn't even looked at until then
+// - until(): when its condition holds. only the behaviors waiting on a condition get it
+//   checked, one call each
+class BehaviorScheduler {
+    enum class Wait { NONE, READY, FRAME, TIMER, CONDITION };
+
+    struct Slot {
+        std::coroutine_handle<> handle;
+        Wait wait;
+        BehaviorCondition condition;
+        void *context;
+        float param;
+        // the timer fired before the behavior got to sleep on it, see sleep()
+        bool woken;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<int> ready, nextFrames, waiting;
+    TimingWheel *timers;
+
+    int resumed, polled;
+
+    // called by the TimingWheel, `context` is the scheduler
+    static void onWake(void *context, int index) {
+        BehaviorScheduler &scheduler = *static_cast<BehaviorScheduler *>(context);
+        Slot &slot = scheduler.slots[index];
+        if (slot.wait == Wait::TIMER) {
+            slot.wait = Wait::READY;
+            scheduler.ready.push_back(index);
+        } else if (slot.handle) {
+            slot.woken = true;
+        }
+    }
+
+    static void removeFrom(std::vector<int> &list, int index) {
+        list.erase(std::remove(list.begin(), list.end(), index), list.end());
+    }
+
+  public:
+    struct SleepAwaiter {
+        BehaviorScheduler &scheduler;
+        int index;
+        TimerHandle &timer;
+        float seconds;
+
+        bool await_ready() {
+            Slot &slot = scheduler.slots[index];
+            if (slot.woken) {
+                slot.woken = false;
+                return true;
+            }
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<>) {
+            // a timer still pending is the same sleep, the behavior was restarted while
+            // sleeping (e.g. after restoring a snapshot) and keeps waiting for it
+            if (!scheduler.timers->isPending(timer)) {
+                timer = scheduler.timers->schedule(seconds, onWake, &scheduler, index);
+            }
+            scheduler.slots[index].wait = Wait::TIMER;
+        }
+        void await_resume() {}
+    };
+
+    struct ConditionAwaiter {
+        BehaviorScheduler &scheduler;
+        int index;
+        BehaviorCondition condition;
+        void *context;
+        float param;
+
+        bool await_ready() { return condition(context, index, param); }
+        void await_suspend(std::coroutine_handle<>) {
+            Slot &slot = scheduler.slots[index];
+            slot.wait = Wait::CONDITION;
+            slot.condition = condition;
+            slot.context = context;
+            slot.param = param;
+            scheduler.waiting.push_back(index);
+        }
+        void await_resume() {}
+    };
+
+    struct FrameAwaiter {
+        BehaviorScheduler &scheduler;
+        int index;
+
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<>) {
+            scheduler.slots[index].wait = Wait::FRAME;
+            scheduler.nextFrames.push_back(index);
+        }
+        void await_resume() {}
+    };
+
+    BehaviorScheduler() : timers(NULL), resumed(0), polled(0) {}
+    BehaviorScheduler(const BehaviorScheduler &) = delete;
+    BehaviorScheduler &operator=(const BehaviorScheduler &) = delete;
+    ~BehaviorScheduler() { clear(); }
+
+    // `count` slots, the timers are the ones of the game so sleeps are in its snapshots
+    void init(int count, TimingWheel &wheel) {
+        clear();
+        timers = &wheel;
+        slots.assign(count, Slot{nullptr, Wait::NONE, NULL, NULL, 0, false});
+        ready.reserve(count);
+        nextFrames.reserve(count);
+        waiting.reserve(count);
+    }
+
+    // replaces the behavior of the slot. it starts on the next run(), so behaviors
+    // always run at the same point of the frame, wherever they were started from
+    void start(int index, Behavior behavior) {
+        stop(index);
+        Slot &slot = slots[index];
+        slot.handle = behavior.release();
+        slot.wait = Wait::READY;
+        ready.push_back(index);
+    }
+
+    // the timer a stopped behavior was sleeping on is left alone, it's up to the caller
+    // to cancel it
+    void stop(int index) {
+        Slot &slot = slots[index];
+        if (slot.handle) {
+            slot.handle.destroy();
+        }
+        if (slot.wait == Wait::READY) {
+            removeFrom(ready, index);
+        } else if (slot.wait == Wait::FRAME) {
+            removeFrom(nextFrames, index);
+        } else if (slot.wait == Wait::CONDITION) {
+            removeFrom(waiting, index);
+        }
+        slot.handle = nullptr;
+        slot.wait = Wait::NONE;
+        slot.woken = false;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < slots.size(); i++) {
+            stop(static_cast<int>(i));
+        }
+    }
+
+    // resumes the behaviors that have something to do this frame. timers go off in
+    // TimingWheel::advance(), call this after it
+    void run() {
+        resumed = 0;
+        polled = 0;
+
+        for (size_t i = 0; i < waiting.size();) {
+            int index = waiting[i];
+            Slot &slot = slots[index];
+            polled++;
+            if (slot.condition(slot.context, index, slot.param)) {
+                slot.wait = Wait::READY;
+                ready.push_back(index);
+                waiting[i] = waiting.back();
+                waiting.pop_back();
+            } else {
+                i++;
+            }
+        }
+        for (int index : nextFrames) {
+            slots[index].wait = Wait::READY;
+            ready.push_back(index);
+        }
+        nextFrames.clear();
+
+        // 💡 always the same order, whatever order they got ready in, so replaying the
+        // same frames gives the same game (see simulationHash())
+        std::sort(ready.begin(), ready.end());
+
+        // behaviors waiting on the next frame go into nextFrames, not here, so this
+        // can't loop forever
+        for (size_t i = 0; i < ready.size(); i++) {
+            Slot &slot = slots[ready[i]];
+            slot.wait = Wait::NONE;
+            slot.handle.resume();
+            resumed++;
+            if (slot.handle.done()) {
+                slot.handle.destroy();
+                slot.handle = nullptr;
+            }
+        }
+        ready.clear();
+    }
+
+    // awaitables, `index` is the slot of the behavior awaiting
+
+    // `timer` has to outlive the sleep, e.g. live in the object's data
+    SleepAwaiter sleep(int index, TimerHandle &timer, float seconds) {
+        return SleepAwaiter{*this, index, timer, seconds};
+    }
+
+    ConditionAwaiter
+    until(int index, BehaviorCondition condition, void *context, float param) {
+        return ConditionAwaiter{*this, index, condition, context, param};
+    }
+
+    FrameAwaiter nextFrame(int index) { return FrameAwaiter{*this, index}; }
+
+    int getRunning() const {
+        int running = 0;
+        for (size_t i = 0; i < slots.size(); i++) {
+            running += slots[i].handle ? 1 : 0;
+        }
+        return running;
+    }
+    // what the last run() did: behaviors resumed and conditions checked
+    int getResumed() const { return resumed; }
+    int getPolled() const { return polled; }
+    int getWaiting() const { return static_cast<int>(waiting.size()); }
+};
+
+#endif
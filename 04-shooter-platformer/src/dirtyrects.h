@@ -0,0 +1,143 @@
+#ifndef dirtyrects_h
+#define dirtyrects_h
+
+#include "SDL3/SDL_rect.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// more regions than this and drawing the frame once is cheaper than going over it again
+// for every region
+const int MAX_DIRTY_REGIONS = 16;
+// same when the regions cover more than this much of the screen
+const float MAX_DIRTY_FRACTION = 0.5f;
+
+// the parts of the screen that change from one frame to the next, for the software
+// renderer. it draws every pixel on the cpu, and most of a frame is the sky, the
+// parallax layers and the tiles, which look the same as last frame while the camera
+// doesn't move. then it's enough to draw again where something moved: where it is now,
+// to draw it, and where it was last frame, to erase it.
+//
+// ⚠️ only works when what was drawn last frame is still there, which is why the game
+// draws into a ScreenTarget, its texture keeps it. the same goes for the window: on
+// partial frames only the regions are scaled up onto it, see
+// ScreenTarget::presentRegions(), so an idle frame copies nothing at all
+class DirtyRegions {
+    SDL_Rect screen;
+    // what moving things covered this frame and last frame
+    std::vector<SDL_Rect> current, previous;
+    std::vector<SDL_Rect> regions;
+    // the whole screen has to be drawn this frame
+    bool full;
+    // what the last build() returned
+    bool partial;
+    float cameraX;
+
+    uint64_t fullFrames, partialFrames;
+    double partialArea;
+
+  public:
+    DirtyRegions()
+        : full(true), partial(false), cameraX(0), fullFrames(0), partialFrames(0),
+          partialArea(0) {
+        screen.x = screen.y = screen.w = screen.h = 0;
+        current.reserve(1024);
+        previous.reserve(1024);
+        regions.reserve(2048);
+    }
+
+    void init(int width, int height) {
+        screen.w = width;
+        screen.h = height;
+        full = true;
+    }
+
+    // something that can look different from last frame is drawn here (logical pixels)
+    void add(const SDL_FRect &rect) {
+        // a pixel of margin, sprites are scaled and filtering can touch the pixels
+        // around them
+        SDL_Rect pixels;
+        pixels.x = static_cast<int>(std::floor(rect.x)) - 1;
+        pixels.y = static_cast<int>(std::floor(rect.y)) - 1;
+        pixels.w = static_cast<int>(std::ceil(rect.x + rect.w)) + 1 - pixels.x;
+        pixels.h = static_cast<int>(std::ceil(rect.y + rect.h)) + 1 - pixels.y;
+        if (SDL_GetRectIntersection(&pixels, &screen, &pixels)) {
+            current.push_back(pixels);
+        }
+    }
+
+    // the whole screen changes this frame: the window was resized, the background
+    // scrolled...
+    void invalidate() { full = true; }
+
+    // when the camera moves everything on screen moves with it
+    void setCamera(float x) {
+        if (x != cameraX) {
+            full = true;
+            cameraX = x;
+        }
+    }
+
+    // works out the regions to draw this frame, returns false when it's the whole screen
+    bool build() {
+        regions.assign(previous.begin(), previous.end());
+        regions.insert(regions.end(), current.begin(), current.end());
+
+        // overlapping regions are merged, so no pixel gets drawn twice
+        bool merged = true;
+        while (merged && !full) {
+            merged = false;
+            for (size_t i = 0; i < regions.size() && !merged; i++) {
+                for (size_t j = i + 1; j < regions.size(); j++) {
+                    if (SDL_HasRectIntersection(&regions[i], &regions[j])) {
+                        SDL_GetRectUnion(&regions[i], &regions[j], &regions[i]);
+                        regions[j] = regions.back();
+                        regions.pop_back();
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        double area = 0;
+        for (size_t i = 0; i < regions.size(); i++) {
+            area += static_cast<double>(regions[i].w) * regions[i].h;
+        }
+        double screenArea = static_cast<double>(screen.w) * screen.h;
+        if (regions.size() > static_cast<size_t>(MAX_DIRTY_REGIONS) ||
+            area > screenArea * MAX_DIRTY_FRACTION) {
+            full = true;
+        }
+
+        if (full) {
+            fullFrames++;
+        } else {
+            partialFrames++;
+            partialArea += screenArea > 0 ? area / screenArea : 0;
+        }
+        partial = !full;
+        return partial;
+    }
+
+    // what build() came up with, only meaningful when it returned true. both stay valid
+    // after endFrame(), until the next build()
+    const std::vector<SDL_Rect> &getRegions() const { return regions; }
+    bool isPartial() const { return partial; }
+
+    // this frame becomes last frame
+    void endFrame() {
+        previous.swap(current);
+        current.clear();
+        full = false;
+    }
+
+    uint64_t getFullFrames() const { return fullFrames; }
+    uint64_t getPartialFrames() const { return partialFrames; }
+    // how much of the screen partial frames drew, on average, from 0 to 1
+    double getPartialCoverage() const {
+        return partialFrames > 0 ? partialArea / partialFrames : 0;
+    }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef drawlist_h
+#define drawlist_h
+
+#include "SDL3/SDL_rect.h"
+#include "SDL3/SDL_render.h"
+#include "arena.h"
+#include <vector>
+
+// a sprite to be drawn this frame. the draw pass fills a list of these and submits them
+// all at once at the end
+struct DrawCommand {
+    SDL_Texture *texture;
+    SDL_FRect srcRect;
+    SDL_FRect destRect;
+    SDL_FlipMode flip;
+    // draws with a redish tint, used when objects get hit
+    bool flash;
+    // can look different next frame (moves, animates, flashes), see DirtyRegions
+    bool dynamic;
+};
+
+typedef std::vector<DrawCommand, ArenaAllocator<DrawCommand>> DrawList;
+
+// what a frame sent to the renderer, reported by --bench
+struct DrawStats {
+    int drawCalls;
+    // draws with another texture than the draw before them. renderers batch draws of the
+    // same texture together, every switch can start a new batch
+    int textureSwitches;
+    SDL_Texture *lastTexture;
+
+    DrawStats() { reset(); }
+
+    void reset() {
+        drawCalls = textureSwitches = 0;
+        lastTexture = NULL;
+    }
+
+    void record(SDL_Texture *texture) {
+        drawCalls++;
+        if (texture != lastTexture) {
+            textureSwitches++;
+            lastTexture = texture;
+        }
+    }
+};
+
+inline void flushDrawList(
+    SDL_Renderer *renderer,
+    const DrawList &drawList,
+    DrawStats &stats) {
+    for (const DrawCommand &cmd : drawList) {
+        stats.record(cmd.texture);
+        if (cmd.flash) {
+            SDL_SetTextureColorModFloat(cmd.texture, 2.5f, 1.0f, 1.0f);
+        }
+
+        if (cmd.flip == SDL_FLIP_NONE) {
+            SDL_RenderTexture(renderer, cmd.texture, &cmd.srcRect, &cmd.destRect);
+        } else {
+            SDL_RenderTextureRotated(
+                renderer,
+                cmd.texture,
+                &cmd.srcRect,
+                &cmd.destRect,
+                0,
+                NULL,
+                cmd.flip);
+        }
+
+        if (cmd.flash) {
+            SDL_SetTextureColorModFloat(cmd.texture, 1.0f, 1.0f, 1.0f);
+        }
+    }
+}
+
+#endif
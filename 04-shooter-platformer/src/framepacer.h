@@ -0,0 +1,226 @@
+#ifndef framepacer_h
+#define framepacer_h
+
+#include "SDL3/SDL_render.h"
+#include "SDL3/SDL_timer.h"
+#include <cmath>
+#include <cstdint>
+
+enum class PacingMode { VSYNC, CAPPED, UNCAPPED };
+
+// rolling window of the last frame times, mean and variance are computed from running
+// sums so reading them is O(1) no matter how big the window is
+class FrameTimeStats {
+    static const int SAMPLE_COUNT = 240;
+    double samples[SAMPLE_COUNT];
+    int next, count;
+    double sum, sumSquared;
+
+  public:
+    FrameTimeStats() { reset(); }
+
+    void reset() {
+        next = count = 0;
+        sum = sumSquared = 0;
+    }
+
+    void record(double seconds) {
+        if (count == SAMPLE_COUNT) {
+            // window is full, the oldest sample leaves before the new one comes in
+            sum -= samples[next];
+            sumSquared -= samples[next] * samples[next];
+        } else {
+            count++;
+        }
+        samples[next] = seconds;
+        sum += seconds;
+        sumSquared += seconds * seconds;
+        next = (next + 1) % SAMPLE_COUNT;
+    }
+
+    int getCount() const { return count; }
+    double mean() const { return count ? sum / count : 0; }
+    double variance() const {
+        if (count < 2) {
+            return 0;
+        }
+        double m = mean();
+        // float rounding on the running sums can make it slightly negative
+        double v = sumSquared / count - m * m;
+        return v > 0 ? v : 0;
+    }
+    double stdDev() const { return std::sqrt(variance()); }
+};
+
+// the frame times of the last minute or so, counted in buckets so percentiles don't need
+// sorting. averages hide stutters, p99 and max are where they show up
+class FrameTimeHistogram {
+    static const int SAMPLE_COUNT = 3600;
+    // 50us wide, up to 50ms. slower frames all go to the last bucket
+    static const int BUCKET_COUNT = 1000;
+    static const uint64_t BUCKET_NS = 50 * 1000;
+
+    float samples[SAMPLE_COUNT];
+    int buckets[BUCKET_COUNT];
+    int next, count;
+
+  public:
+    FrameTimeHistogram() { reset(); }
+
+    void reset() {
+        next = count = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            buckets[i] = 0;
+        }
+    }
+
+    void record(double seconds) {
+        if (count == SAMPLE_COUNT) {
+            buckets[bucketOf(samples[next])]--;
+        } else {
+            count++;
+        }
+        samples[next] = static_cast<float>(seconds);
+        buckets[bucketOf(samples[next])]++;
+        next = (next + 1) % SAMPLE_COUNT;
+    }
+
+    // the time `fraction` of the frames took at most, 0.99 for p99. it's the end of the
+    // bucket, so it's up to 50us over the real value (but never over the max)
+    double percentile(double fraction) const {
+        if (count == 0) {
+            return 0;
+        }
+        double slowest = max();
+        int wanted = static_cast<int>(std::ceil(fraction * count));
+        int seen = 0;
+        for (int i = 0; i < BUCKET_COUNT - 1; i++) {
+            seen += buckets[i];
+            if (seen >= wanted) {
+                double end = static_cast<double>((i + 1) * BUCKET_NS) / SDL_NS_PER_SECOND;
+                return end < slowest ? end : slowest;
+            }
+        }
+        // past the last bucket we don't know better than the slowest frame
+        return slowest;
+    }
+
+    double max() const {
+        float slowest = 0;
+        for (int i = 0; i < count; i++) {
+            slowest = samples[i] > slowest ? samples[i] : slowest;
+        }
+        return slowest;
+    }
+
+    int getCount() const { return count; }
+
+  private:
+    static int bucketOf(float seconds) {
+        int bucket = static_cast<int>(seconds * SDL_NS_PER_SECOND / BUCKET_NS);
+        return bucket < 0 ? 0 : (bucket >= BUCKET_COUNT ? BUCKET_COUNT - 1 : bucket);
+    }
+};
+
+// decides how the main loop waits between frames:
+// - VSYNC lets the driver block on present, locked to the monitor refresh rate
+// - CAPPED runs at an arbitrary fps using our own limiter (works on any monitor)
+// - UNCAPPED never waits, used for benchmarking
+class FramePacer {
+    PacingMode mode;
+    int targetFps;
+
+    // the absolute time (ns) the next frame is allowed to start at. we chase deadlines
+    // instead of sleeping "period - frameTime" so the small errors don't add up
+    uint64_t nextDeadline;
+
+    // OS sleeps are only accurate to a millisecond or two, so we sleep until we're this
+    // close to the deadline and then spin for the rest
+    uint64_t spinThreshold;
+
+    FrameTimeStats stats;
+    FrameTimeHistogram histogram;
+
+  public:
+    FramePacer()
+        : mode(PacingMode::VSYNC), targetFps(60), nextDeadline(0),
+          spinThreshold(2 * SDL_NS_PER_MS) {}
+
+    void setMode(SDL_Renderer *renderer, PacingMode newMode) {
+        mode = newMode;
+        // when CAPPED we're the ones limiting, vsync would fight our limiter
+        SDL_SetRenderVSync(renderer, mode == PacingMode::VSYNC ? 1 : 0);
+        nextDeadline = 0;
+        stats.reset();
+        histogram.reset();
+    }
+
+    void setTargetFps(int fps) { targetFps = fps > 0 ? fps : 60; }
+
+    // cycle VSYNC -> CAPPED -> UNCAPPED, handy to compare them while playing
+    void cycleMode(SDL_Renderer *renderer) {
+        switch (mode) {
+        case PacingMode::VSYNC:
+            setMode(renderer, PacingMode::CAPPED);
+            break;
+        case PacingMode::CAPPED:
+            setMode(renderer, PacingMode::UNCAPPED);
+            break;
+        case PacingMode::UNCAPPED:
+            setMode(renderer, PacingMode::VSYNC);
+            break;
+        }
+    }
+
+    // feed the measured delta time of every frame
+    void record(float deltaTime) {
+        stats.record(deltaTime);
+        histogram.record(deltaTime);
+    }
+
+    // call once per frame after presenting, only blocks in CAPPED mode
+    void wait() {
+        if (mode != PacingMode::CAPPED) {
+            return;
+        }
+
+        const uint64_t period = SDL_NS_PER_SECOND / targetFps;
+        uint64_t now = SDL_GetTicksNS();
+
+        if (nextDeadline == 0 || now > nextDeadline + period) {
+            // first frame or we missed by more than a whole frame (hitch, window drag),
+            // start over from now instead of trying to catch up with a burst of frames
+            nextDeadline = now + period;
+        }
+
+        if (nextDeadline > now + spinThreshold) {
+            SDL_DelayNS(nextDeadline - now - spinThreshold);
+        }
+
+        // ⚠️ burns one core for the last ~2ms of every frame, that's the price of precise
+        // pacing
+        while (SDL_GetTicksNS() < nextDeadline) {
+        }
+
+        nextDeadline += period;
+    }
+
+    PacingMode getMode() const { return mode; }
+    int getTargetFps() const { return targetFps; }
+    const FrameTimeStats &getStats() const { return stats; }
+    const FrameTimeHistogram &getHistogram() const { return histogram; }
+
+    const char *getModeName() const {
+        switch (mode) {
+        case PacingMode::VSYNC:
+            return "vsync";
+        case PacingMode::CAPPED:
+            return "capped";
+        case PacingMode::UNCAPPED:
+            return "uncapped";
+        }
+        return "unknown";
+    }
+};
+
+#endif
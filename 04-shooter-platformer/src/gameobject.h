@@ -3,33 +3,46 @@
 
 #include "SDL3/SDL_rect.h"
 #include "SDL3/SDL_render.h"
-#include "animation.h"
-#include "timer.h"
+#include "texturemanager.h"
+#include "timingwheel.h"
+#include <cstdint>
 #include <glm/glm.hpp>
-#include <vector>
 
 enum class PlayerState { IDLE, WALKING, RUNNING, JUMPING };
 enum class BulletState { MOVING, COLLIDING, INACTIVE };
-enum class EnemyState { IDLE, WALKING, DAMAGED, DEAD };
+// JUMPING is a jump of the nav graph, launched already aimed at where it lands
+enum class EnemyState { IDLE, WALKING, JUMPING, DAMAGED, DEAD };
+
+// how long the timers of the objects below last, in seconds
+const float WEAPON_CAST_TIME = 0.8f;
+const float ENEMY_DAMAGED_TIME = 0.5f;
+const float FLASH_TIME = 0.05f;
 
 struct PlayerData {
     PlayerState state;
-    Timer weaponTimer;
+    TimerHandle weaponTimer;
+    bool weaponReady;
 
     // weapon timer here is working like a COOLDOWN to a specific skill! that's fucking
     // cool. I imagine a skill system where we'd have a specific timer for each skill in
     // the game. so we'd have a SkillObject or something like that would have their
     // specific timers for when they're cast
-    PlayerData() : state(PlayerState::IDLE), weaponTimer(0.8f) {}
+    //
+    // the timers are scheduled in the GameState::timers wheel, so they cost nothing
+    // while waiting and we can have as many skills as we want
+    PlayerData() : state(PlayerState::IDLE), weaponReady(false) {}
 };
 
 struct LevelData {};
 
 struct EnemyData {
     EnemyState state;
-    Timer damagedTimer;
+    // where its behavior wants to go: -1 left, 1 right, 0 stay
+    float steering;
+    // what its behavior sleeps on, see BehaviorScheduler::sleep()
+    TimerHandle wakeTimer;
     int health;
-    EnemyData() : state(EnemyState::IDLE), damagedTimer(0.5f), health(20) {}
+    EnemyData() : state(EnemyState::IDLE), steering(0), health(20) {}
 };
 
 struct BulletData {
@@ -49,23 +62,58 @@ struct ObjectData {
     BulletData bullet;
 };
 
-enum class ObjectType { PLAYER, LEVEL, ENEMY, BULLET };
+enum class ObjectType { PLAYER, LEVEL, ENEMY, BULLET, COUNT };
+
+const int OBJECT_TYPE_COUNT = static_cast<int>(ObjectType::COUNT);
+
+// every object type is a collision layer, masks are sets of layers
+typedef uint32_t CollisionMask;
+
+constexpr CollisionMask collisionBit(ObjectType type) {
+    return 1u << static_cast<int>(type);
+}
+
+// the layers a moving object reacts to, by type. pairs that aren't in here are skipped
+// before any rect math, so this has to match what collisionResponse() does with them.
+// new object types get a line here
+const CollisionMask COLLISION_MATRIX[OBJECT_TYPE_COUNT] = {
+    // PLAYER: stands on the level, walks through enemies
+    collisionBit(ObjectType::LEVEL),
+    // LEVEL: never reacts, it's only ever hit
+    0,
+    // ENEMY: blocked by anything that isn't a character
+    collisionBit(ObjectType::LEVEL) | collisionBit(ObjectType::BULLET),
+    // BULLET: stops at the level, hurts enemies
+    collisionBit(ObjectType::LEVEL) | collisionBit(ObjectType::ENEMY),
+};
 
 // every single object in the game
 struct GameObject {
     ObjectType type;
     ObjectData data;
 
+    // the layer the object is on and the layers it reacts to, set by setType() from the
+    // COLLISION_MATRIX. objects can change them afterwards
+    CollisionMask collisionLayer;
+    CollisionMask collisionMask;
+
+    // never moves: update() is never called on it, it's only there for moving objects to
+    // collide with. level tiles are, there's hundreds of them and they'd scan every
+    // other object each frame for nothing
+    bool staticBody;
+
     glm::vec2 position, velocity, acceleration;
 
     // 1 right, -1 left
     float direction;
     float maxSpeedX;
 
-    std::vector<Animation> animations;
+    // the clip being played (one of the Resources::ANIM_* ids) and the handle of the
+    // object's playback in the AnimationSystem, -1 when the object isn't animated
     int currentAnimation;
+    int animation;
 
-    SDL_Texture *texture;
+    TextureHandle texture;
 
     /**
      * controls whether its affected by gravity or not
@@ -77,14 +125,14 @@ struct GameObject {
 
     bool grounded;
 
-    Timer flashTimer;
+    TimerHandle flashTimer;
     bool shouldFlash;
 
     int spriteFrame;
 
-    GameObject() : flashTimer(0.05f) {
+    GameObject() {
         data = ObjectData();
-        type = ObjectType::LEVEL;
+        setType(ObjectType::LEVEL);
 
         direction = 1;
         // max speed is used here to make sure we dont have infinite acceleration
@@ -94,6 +142,7 @@ struct GameObject {
 
         // when -1 it's unset
         currentAnimation = -1;
+        animation = -1;
 
         // by default objects don't have gravity
         dynamic = false;
@@ -103,12 +152,24 @@ struct GameObject {
 
         grounded = false;
 
-        texture = NULL;
+        texture = NO_TEXTURE;
 
         shouldFlash = false;
 
         spriteFrame = 1;
     }
+
+    void setType(ObjectType newType) {
+        type = newType;
+        collisionLayer = collisionBit(newType);
+        collisionMask = COLLISION_MATRIX[static_cast<int>(newType)];
+        staticBody = newType == ObjectType::LEVEL;
+    }
+
+    // can this object be stopped, or hurt, by `other`
+    bool reactsTo(const GameObject &other) const {
+        return (collisionMask & other.collisionLayer) != 0;
+    }
 };
 
 #endif
@@ -0,0 +1,143 @@
+#ifndef hud_h
+#define hud_h
+
+#include "SDL3/SDL_render.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// how often the text of a HudLayer is formatted again, 4 times per second is as fast as
+// anyone reads numbers anyway
+const float HUD_REFRESH_TIME = 0.25f;
+// longest line, in characters. longer text is cut
+const int HUD_MAX_LINE = 120;
+
+// a line of text drawn once into its own texture. drawing it is a single textured quad,
+// the glyphs are only drawn again when the text changes
+class HudText {
+    SDL_Texture *texture;
+    char text[HUD_MAX_LINE + 1];
+    int length;
+
+  public:
+    HudText() : texture(NULL), length(0) { text[0] = '\0'; }
+
+    // the texture is made on the first set(), as wide as the longest line can get
+    void set(SDL_Renderer *renderer, const char *newText, SDL_Color color) {
+        if (texture && std::strncmp(text, newText, HUD_MAX_LINE) == 0) {
+            return;
+        }
+        std::strncpy(text, newText, HUD_MAX_LINE);
+        text[HUD_MAX_LINE] = '\0';
+        length = static_cast<int>(std::strlen(text));
+
+        if (!texture) {
+            texture = SDL_CreateTexture(
+                renderer,
+                SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_TARGET,
+                HUD_MAX_LINE * SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE,
+                SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE);
+            if (!texture) {
+                return;
+            }
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+        }
+
+        // 💡 whatever the caller was drawing into is restored after, and so is the color
+        SDL_Texture *previousTarget = SDL_GetRenderTarget(renderer);
+        Uint8 r, g, b, a;
+        SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+
+        SDL_SetRenderTarget(renderer, texture);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderDebugText(renderer, 0, 0, text);
+
+        SDL_SetRenderTarget(renderer, previousTarget);
+        SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    }
+
+    void draw(SDL_Renderer *renderer, float x, float y) const {
+        if (!texture || length == 0) {
+            return;
+        }
+        const float size = SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+        SDL_FRect src = {0, 0, length * size, size};
+        SDL_FRect dest = {x, y, length * size, size};
+        SDL_RenderTexture(renderer, texture, &src, &dest);
+    }
+
+    void destroy() {
+        SDL_DestroyTexture(texture);
+        texture = NULL;
+    }
+};
+
+// lines of text that stay on screen, like the debug overlay. the text is formatted and
+// drawn into textures a few times per second (see HUD_REFRESH_TIME) instead of every
+// frame, and only the lines that changed are drawn again.
+//
+//     if (hud.beginRefresh(deltaTime)) {
+//         hud.setLine(renderer, 0, "...");
+//     }
+//     hud.draw(renderer, x, y);
+class HudLayer {
+    std::vector<HudText> lines;
+    SDL_Color color;
+    float lineHeight;
+    float sinceRefresh;
+    bool refreshNow;
+    uint64_t refreshes;
+
+  public:
+    HudLayer()
+        : lineHeight(10), sinceRefresh(0), refreshNow(true), refreshes(0) {
+        color.r = color.g = color.b = 0;
+        color.a = 255;
+    }
+
+    void init(int lineCount, SDL_Color textColor, float height) {
+        lines.resize(lineCount);
+        color = textColor;
+        lineHeight = height;
+        refreshNow = true;
+    }
+
+    // true when the lines should be set again this frame
+    bool beginRefresh(float deltaTime) {
+        sinceRefresh += deltaTime;
+        if (!refreshNow && sinceRefresh < HUD_REFRESH_TIME) {
+            return false;
+        }
+        sinceRefresh = 0;
+        refreshNow = false;
+        refreshes++;
+        return true;
+    }
+
+    // the next beginRefresh() says yes, e.g. when the layer shows up after being hidden
+    void invalidate() { refreshNow = true; }
+
+    void setLine(SDL_Renderer *renderer, int index, const char *text) {
+        lines[index].set(renderer, text, color);
+    }
+
+    void draw(SDL_Renderer *renderer, float x, float y) const {
+        for (size_t i = 0; i < lines.size(); i++) {
+            lines[i].draw(renderer, x, y + i * lineHeight);
+        }
+    }
+
+    uint64_t getRefreshes() const { return refreshes; }
+
+    void destroy() {
+        for (size_t i = 0; i < lines.size(); i++) {
+            lines[i].destroy();
+        }
+    }
+};
+
+#endif
@@ -7,27 +7,47 @@
 #include "SDL3/SDL_surface.h"
 #include "SDL3/SDL_timer.h"
 #include "SDL3/SDL_video.h"
+#include "alloctracker.h"
 #include "animation.h"
+#include "animationsystem.h"
+#include "arena.h"
+#include "audio.h"
+#include "behavior.h"
+#include "dirtyrects.h"
+#include "drawlist.h"
+#include "framepacer.h"
 #include "gameobject.h"
+#include "hud.h"
+#include "navgraph.h"
+#include "particles.h"
+#include "profiler.h"
+#include "screentarget.h"
+#include "snapshot.h"
 #include "state.h"
-#include "timer.h"
+#include "texturemanager.h"
+#include "timingwheel.h"
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_events.h>
 #include <SDL3_image/SDL_image.h>
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <ios>
 #include <iostream>
 #include <vector>
 
-const char *formatText(const char *fmt, ...) {
-    static char buffer[256]; // static = persists after function returns
+// the text lives in the frame arena, so it's valid until the end of the frame and many
+// formatted strings can be alive at the same time
+const char *formatText(FrameArena &arena, const char *fmt, ...) {
+    const size_t size = 256;
+    char *buffer = static_cast<char *>(arena.allocate(size, 1));
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    vsnprintf(buffer, size, fmt, args);
     va_end(args);
     return buffer;
 }
@@ -38,6 +58,35 @@ const int MAX_LAYERS = 2;
 const int MAP_ROWS = 6;
 const int MAP_COLS = 50;
 const int TILE_SIZE = 32;
+// pulls dynamic objects down, in pixels per second squared
+const float GRAVITY = 2000.0f;
+// bullets are reused once inactive, the pool only grows past this when the screen is
+// full of them
+const int BULLET_POOL_SIZE = 64;
+// frames played before --alloc-test starts checking, gives pools time to warm up
+const int ALLOC_TEST_WARMUP_FRAMES = 120;
+// memory for everything that only lives during one frame (draw list, contacts, text)
+const size_t FRAME_ARENA_SIZE = 256 * 1024;
+// frames kept for rewinding and rollback, and how many bytes each snapshot can take
+// without allocating (a full bullet pool and lots of timers stay well under it)
+const int HISTORY_FRAMES = 120;
+const size_t SNAPSHOT_RESERVE = 64 * 1024;
+// how far back the rollback test (F6) goes
+const int ROLLBACK_TEST_FRAMES = 60;
+// where HitchRecorder writes
+const char *const HITCH_LOG_PATH = "hitches.log";
+// lines of the debug overlay
+const int DEBUG_HUD_LINES = 12;
+
+// two objects touching, recorded during update so we can inspect them later in the frame
+struct Contact {
+    GameObject *objA;
+    GameObject *objB;
+    SDL_FRect intersection;
+};
+
+typedef std::vector<Contact, ArenaAllocator<Contact>> ContactList;
+typedef std::vector<SDL_FRect, ArenaAllocator<SDL_FRect>> RectList;
 
 struct GameState {
     std::array<std::vector<GameObject>, MAX_LAYERS> layers;
@@ -58,125 +107,303 @@ struct GameState {
 
     bool debugMode;
 
-    GameState(const SDLState &state) {
+    // every animated object has a playback in here, see GameObject::animation
+    AnimationSystem animations;
+
+    // cooldowns and durations of the objects, see gameobject.h
+    TimingWheel timers;
+
+    // the AI of every enemy, see enemyBehavior(). coroutines can't go in a snapshot, so
+    // they're started over from the restored state instead, see startEnemyBehaviors()
+    BehaviorScheduler behaviors;
+
+    // where enemies can walk and jump, built with the map. navTarget is the node the
+    // player is on (or was on last, while in the air), -1 until we know
+    NavGraph nav;
+    int navTarget;
+
+    // sparks and dust, only for looks, nothing in the game reads them
+    ParticleSystem particles;
+
+    // state of the game's random numbers, it's in the snapshots so replayed frames get
+    // the same numbers again
+    Uint64 rngState;
+
+    // per frame data, everything below is backed by the frame arena and is thrown away
+    // by beginFrame()
+    FrameArena frameArena;
+    DrawList drawList;
+    ContactList contacts;
+    RectList debugRects;
+    DrawStats drawStats;
+    // how long each part of the frame took, see FrameProfiler
+    FrameProfiler profiler;
+    // pairs of objects checked for collisions this frame and pairs skipped by their
+    // collision masks
+    int collisionChecks, collisionSkips;
+
+    GameState(const SDLState &state)
+        : frameArena(FRAME_ARENA_SIZE), drawList(ArenaAllocator<DrawCommand>(frameArena)),
+          contacts(ArenaAllocator<Contact>(frameArena)),
+          debugRects(ArenaAllocator<SDL_FRect>(frameArena)) {
         playerIndex = -1; // will change automatically on map loading
+        navTarget = -1;
+        collisionChecks = collisionSkips = 0;
+        rngState = SDL_GetPerformanceCounter();
         mapViewport =
             {0, 0, static_cast<float>(state.logW), static_cast<float>(state.logH)};
 
         bg2Scroll = bg3Scroll = bg4Scroll = bg5Scroll = 0;
 
         debugMode = false;
+
+        bullets.reserve(BULLET_POOL_SIZE);
+        animations.reserve(BULLET_POOL_SIZE + 64);
+        timers.reserve(256);
     }
 
     GameObject &player() { return layers[LAYER_IDX_CHARACTERS][playerIndex]; };
+
+    // everything the simulation needs to go back in time, see snapshot.h. the level
+    // layer never changes after loading, particles are only for looks and the nav
+    // graph's cache is rebuilt on demand, so they're left out
+    void save(Snapshot &snapshot) const {
+        snapshot.writeVector(layers[LAYER_IDX_CHARACTERS]);
+        snapshot.writeVector(bullets);
+        snapshot.write(playerIndex);
+        snapshot.write(mapViewport);
+        snapshot.write(bg2Scroll);
+        snapshot.write(bg3Scroll);
+        snapshot.write(bg4Scroll);
+        snapshot.write(bg5Scroll);
+        snapshot.write(navTarget);
+        snapshot.write(rngState);
+        animations.save(snapshot);
+        timers.save(snapshot);
+    }
+
+    void restore(Snapshot &snapshot) {
+        snapshot.rewind();
+        snapshot.readVector(layers[LAYER_IDX_CHARACTERS]);
+        snapshot.readVector(bullets);
+        snapshot.read(playerIndex);
+        snapshot.read(mapViewport);
+        snapshot.read(bg2Scroll);
+        snapshot.read(bg3Scroll);
+        snapshot.read(bg4Scroll);
+        snapshot.read(bg5Scroll);
+        snapshot.read(navTarget);
+        snapshot.read(rngState);
+        animations.restore(snapshot);
+        timers.restore(snapshot);
+    }
+
+    void beginFrame() {
+        // 💡 clear() would keep the capacity, which points into memory we're about to
+        // rewind. swapping with an empty list makes them let go of it
+        DrawList(drawList.get_allocator()).swap(drawList);
+        ContactList(contacts.get_allocator()).swap(contacts);
+        RectList(debugRects.get_allocator()).swap(debugRects);
+
+        frameArena.reset();
+        drawStats.reset();
+        collisionChecks = collisionSkips = 0;
+
+        // reserving once avoids the list leaving old copies behind in the arena as it
+        // grows
+        drawList.reserve(512);
+        contacts.reserve(64);
+    }
+};
+
+// what the player did during a frame, recorded so the frame can be simulated again
+struct FrameInput {
+    float deltaTime;
+    bool left, right, shoot;
+    // space was pressed this frame
+    bool jump;
 };
 
+// settings that come from the command line, e.g. `./mygame --fps 144`
+struct GameOptions {
+    PacingMode pacingMode;
+    int targetFps;
+
+    // when > 0 the game plays itself for this many frames and fails if any of them
+    // allocated memory
+    int allocTestFrames;
+
+    // textures over the budget, or unused for textureEvictFrames, are unloaded
+    size_t textureBudgetMB;
+    int textureEvictFrames;
+    // frames slower than this get written down in HITCH_LOG_PATH, 0 never
+    double hitchMs;
+
+    // load the textures that allow it in 16 bit formats, see TextureManager
+    bool compactTextures;
+
+    // draw with SDL's software renderer, and only draw again what changed between
+    // frames (see DirtyRegions)
+    bool software;
+    bool dirtyRects;
+
+    // when > 0 there's no window, the game draws this many frames with the software
+    // renderer and prints how long they took, see runBenchmark()
+    int benchFrames;
+
+    GameOptions() {
+        pacingMode = PacingMode::VSYNC;
+        targetFps = 60;
+        allocTestFrames = 0;
+        textureBudgetMB = 64;
+        textureEvictFrames = 600;
+        compactTextures = false;
+        hitchMs = 50;
+        benchFrames = 0;
+        software = false;
+        dirtyRects = false;
+    }
+};
+
+GameOptions parseOptions(int argc, char *argv[]) {
+    GameOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--vsync") == 0) {
+            options.pacingMode = PacingMode::VSYNC;
+        } else if (std::strcmp(argv[i], "--uncapped") == 0) {
+            options.pacingMode = PacingMode::UNCAPPED;
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            options.pacingMode = PacingMode::CAPPED;
+            options.targetFps = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--alloc-test") == 0 && i + 1 < argc) {
+            options.allocTestFrames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+            options.textureBudgetMB = std::strtoul(argv[++i], NULL, 10);
+        } else if (std::strcmp(argv[i], "--texture-evict") == 0 && i + 1 < argc) {
+            options.textureEvictFrames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--hitch-ms") == 0 && i + 1 < argc) {
+            options.hitchMs = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--compact-textures") == 0) {
+            options.compactTextures = true;
+        } else if (std::strcmp(argv[i], "--software") == 0) {
+            options.software = true;
+        } else if (std::strcmp(argv[i], "--dirty-rects") == 0) {
+            // redrawing part of the screen only works when the rest stays there
+            options.software = options.dirtyRects = true;
+        } else if (std::strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            options.benchFrames = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+        }
+    }
+    return options;
+}
+
 struct Resources {
+    // every clip of the game lives in `animations`, objects refer to them by these ids
     const int ANIM_PLAYER_IDLE = 0;
     const int ANIM_PLAYER_WALK = 1;
     const int ANIM_PLAYER_RUN = 2;
     const int ANIM_PLAYER_JUMP = 3;
     const int ANIM_PLAYER_SLIDE = 4;
-    const int ANIM_PLAYER_SHOOTING = 4;
-    std::vector<Animation> playerAnims;
-
-    const int ANIM_BULLET_MOVING = 0;
-    const int ANIM_BULLET_HIT = 1;
-    std::vector<Animation> bulletAnims;
-
-    const int ANIM_ENEMY_IDLE = 0;
-    const int ANIM_ENEMY_WALK = 1;
-    const int ANIM_ENEMY_HIT = 2;
-    const int ANIM_ENEMY_DEAD = 3;
-    std::vector<Animation> enemyAnims;
-
-    std::vector<SDL_Texture *> textures;
-    SDL_Texture *idleTexture, *runTexture, *walkTexture, *slideTexture, *jumpTexture,
-        *shootingTexture, *grassTexture, *groundTexture, *panelTexture, *brickTexture,
-        *bg1Texture, *bg2Texture, *bg3Texture, *bg4Texture, *bg5Texture, *bulletTexture,
-        *bulletHitTexture, *enemyIdleTexture, *enemyWalkTexture, *enemyHitTexture,
-        *enemyDeadTexture;
-
-    SDL_Texture *loadTexture(SDL_Renderer *renderer, const std::string &filePath) {
-        SDL_Texture *texture = IMG_LoadTexture(renderer, filePath.c_str());
-        // this makes the sprite to be streched without "antialiasing"
-        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
-
-        if (!texture) {
-            std::cerr << "IMG_LoadTexture failed: " << filePath << SDL_GetError()
-                      << std::endl;
-            return texture;
-        }
-        textures.push_back(texture);
+    const int ANIM_PLAYER_SHOOTING = 5;
 
-        return texture;
-    }
+    const int ANIM_BULLET_MOVING = 6;
+    const int ANIM_BULLET_HIT = 7;
+
+    const int ANIM_ENEMY_IDLE = 8;
+    const int ANIM_ENEMY_WALK = 9;
+    const int ANIM_ENEMY_HIT = 10;
+    const int ANIM_ENEMY_DEAD = 11;
+
+    const int ANIM_COUNT = 12;
+    std::vector<Animation> animations;
 
-    void load(SDLState &state) {
-        playerAnims.resize(5);
-        playerAnims[ANIM_PLAYER_IDLE] = Animation(2, 1);
-        playerAnims[ANIM_PLAYER_WALK] = Animation(7, 0.8);
-        playerAnims[ANIM_PLAYER_RUN] = Animation(8, 0.5);
-        playerAnims[ANIM_PLAYER_JUMP] = Animation(8, 2);
-        playerAnims[ANIM_PLAYER_SLIDE] = Animation(1, 1);
-        playerAnims[ANIM_PLAYER_SHOOTING] = Animation(13, 1);
+    // sounds play on their own thread, see audio.h
+    AudioEngine audio;
 
-        bulletAnims.resize(2);
-        bulletAnims[ANIM_BULLET_MOVING] = Animation(4, 0.5f);
-        bulletAnims[ANIM_BULLET_HIT] = Animation(4, 0.15f);
+    // textures are loaded on first use, see texturemanager.h
+    TextureManager textures;
+    TextureHandle idleTexture, runTexture, walkTexture, slideTexture, jumpTexture,
+        shootingTexture, grassTexture, groundTexture, panelTexture, brickTexture,
+        bg1Texture, bg2Texture, bg3Texture, bg4Texture, bg5Texture, bulletTexture,
+        bulletHitTexture, enemyIdleTexture, enemyWalkTexture, enemyHitTexture,
+        enemyDeadTexture;
 
-        enemyAnims.resize(4);
-        enemyAnims[ANIM_ENEMY_IDLE] = Animation(7, 1.0f);
-        enemyAnims[ANIM_ENEMY_WALK] = Animation(7, 1.0f);
-        enemyAnims[ANIM_ENEMY_HIT] = Animation(2, 0.5f);
-        enemyAnims[ANIM_ENEMY_DEAD] = Animation(4, 0.7f);
+    void load(SDLState &state, const GameOptions &options) {
+        textures.init(
+            state.renderer,
+            options.textureBudgetMB * 1024 * 1024,
+            options.textureEvictFrames,
+            options.compactTextures);
 
         // player
-        idleTexture = loadTexture(state.renderer, "./assets/prototype/HMMIdleStaff.png");
-        runTexture = loadTexture(state.renderer, "./assets/prototype/HMMRunStaff.png");
-        walkTexture = loadTexture(state.renderer, "./assets/prototype/HMMWalkStaff.png");
-        jumpTexture = loadTexture(state.renderer, "./assets/prototype/HMMJumpStaff.png");
-        slideTexture = loadTexture(state.renderer, "./assets/prototype/HMMRunStaff.png");
-        shootingTexture =
-            loadTexture(state.renderer, "./assets/prototype/HMMStaffCast.png");
+        idleTexture = textures.add("./assets/prototype/HMMIdleStaff.png");
+        runTexture = textures.add("./assets/prototype/HMMRunStaff.png");
+        walkTexture = textures.add("./assets/prototype/HMMWalkStaff.png");
+        jumpTexture = textures.add("./assets/prototype/HMMJumpStaff.png");
+        slideTexture = textures.add("./assets/prototype/HMMRunStaff.png");
+        shootingTexture = textures.add("./assets/prototype/HMMStaffCast.png");
         //
-        // idleTexture = loadTexture(state.renderer, "./assets/light/Idle.png");
-        // runTexture = loadTexture(state.renderer, "./assets/light/Run.png");
-        // walkTexture = loadTexture(state.renderer, "./assets/light/Walk.png");
-        // jumpTexture = loadTexture(state.renderer, "./assets/light/Jump.png");
-        // slideTexture = loadTexture(state.renderer, "./assets/light/Run.png");
+        // idleTexture = textures.add("./assets/light/Idle.png");
+        // runTexture = textures.add("./assets/light/Run.png");
+        // walkTexture = textures.add("./assets/light/Walk.png");
+        // jumpTexture = textures.add("./assets/light/Jump.png");
+        // slideTexture = textures.add("./assets/light/Run.png");
 
         // map
-        grassTexture = loadTexture(state.renderer, "./assets/map/grass.png");
-        groundTexture = loadTexture(state.renderer, "./assets/map/ground.png");
-        panelTexture = loadTexture(state.renderer, "./assets/map/panel.png");
-        brickTexture = loadTexture(state.renderer, "./assets/map/brick.png");
+        grassTexture = textures.add("./assets/map/grass.png");
+        groundTexture = textures.add("./assets/map/ground.png");
+        panelTexture = textures.add("./assets/map/panel.png");
+        brickTexture = textures.add("./assets/map/brick.png");
 
         // background
-        bg1Texture = loadTexture(state.renderer, "./assets/map/bg/sky.png");
-        bg2Texture = loadTexture(state.renderer, "./assets/map/bg/foreground_trees.png");
-        bg3Texture = loadTexture(state.renderer, "./assets/map/bg/back_trees.png");
-        bg4Texture = loadTexture(state.renderer, "./assets/map/bg/hills.png");
-        bg5Texture = loadTexture(state.renderer, "./assets/map/bg/clouds.png");
+        bg1Texture = textures.add("./assets/map/bg/sky.png");
+        bg2Texture = textures.add("./assets/map/bg/foreground_trees.png");
+        bg3Texture = textures.add("./assets/map/bg/back_trees.png");
+        bg4Texture = textures.add("./assets/map/bg/hills.png");
+        bg5Texture = textures.add("./assets/map/bg/clouds.png");
 
         // bullets
-        bulletTexture = loadTexture(state.renderer, "./assets/bullet.png");
-        bulletHitTexture = loadTexture(state.renderer, "./assets/bullet_hit.png");
+        bulletTexture = textures.add("./assets/bullet.png");
+        bulletHitTexture = textures.add("./assets/bullet_hit.png");
 
         // enemy
-        enemyIdleTexture = loadTexture(state.renderer, "./assets/skeleton/Idle.png");
-        enemyWalkTexture = loadTexture(state.renderer, "./assets/skeleton/Walk.png");
-        enemyDeadTexture = loadTexture(state.renderer, "./assets/skeleton/Dead.png");
-        enemyHitTexture = loadTexture(state.renderer, "./assets/skeleton/Hurt.png");
+        enemyIdleTexture = textures.add("./assets/skeleton/Idle.png");
+        enemyWalkTexture = textures.add("./assets/skeleton/Walk.png");
+        enemyDeadTexture = textures.add("./assets/skeleton/Dead.png");
+        enemyHitTexture = textures.add("./assets/skeleton/Hurt.png");
+
+        // frame count, duration and the size of each frame in the sprite sheet
+        animations.resize(ANIM_COUNT);
+        animations[ANIM_PLAYER_IDLE] = Animation(2, 1, 256);
+        animations[ANIM_PLAYER_WALK] = Animation(7, 0.8, 256);
+        animations[ANIM_PLAYER_RUN] = Animation(8, 0.5, 256);
+        animations[ANIM_PLAYER_JUMP] = Animation(8, 2, 256);
+        animations[ANIM_PLAYER_SLIDE] = Animation(1, 1, 256);
+        animations[ANIM_PLAYER_SHOOTING] = Animation(13, 1, 256);
+
+        // bullet frames are as wide as the sheet is tall
+        const float bulletSize = static_cast<float>(textures.getHeight(bulletTexture));
+        animations[ANIM_BULLET_MOVING] = Animation(4, 0.5f, bulletSize);
+        animations[ANIM_BULLET_HIT] = Animation(4, 0.15f, bulletSize);
+
+        animations[ANIM_ENEMY_IDLE] = Animation(7, 1.0f, 128);
+        animations[ANIM_ENEMY_WALK] = Animation(7, 1.0f, 128);
+        animations[ANIM_ENEMY_HIT] = Animation(2, 0.5f, 128);
+        animations[ANIM_ENEMY_DEAD] = Animation(4, 0.7f, 128);
+
+        audio.init();
     }
     void unload() {
-        for (auto *texture : textures) {
-            SDL_DestroyTexture(texture);
-        }
+        audio.shutdown();
+        textures.unloadAll();
     }
 };
 
-bool initialize(SDLState &state);
+bool initialize(SDLState &state, const char *rendererName);
+bool initializeOffscreen(SDLState &state, SDL_Surface *&target);
+int runBenchmark(const GameOptions &options);
 void cleanup(SDLState &state);
 void update(
     const SDLState &state,
@@ -185,12 +412,12 @@ void update(
     GameObject &obj,
     float deltaTime);
 void drawObject(
-    const SDLState &state,
     GameState &gs,
+    Resources &res,
     GameObject &obj,
     const float srcSize,
-    const float destSize,
-    float deltaTime);
+    const float destSize);
+void drawTile(GameState &gs, Resources &res, GameObject &obj);
 GameObject createObject(const SDLState &state, int r, int c, ObjectType type);
 void createTiles(const SDLState &state, GameState &gs, Resources &res);
 void checkCollision(
@@ -206,13 +433,28 @@ void handleKeyInput(
     GameObject &obj,
     SDL_Scancode key,
     bool keyDown);
-void drawParallaxBackground(
-    const SDLState &state,
+void scrollParallaxBackground(
     SDL_Texture *texture,
     float xVelocity,
     float &scrollPos,
     float scrollFactor,
     float deltaTime);
+void drawParallaxBackground(
+    const SDLState &state,
+    SDL_Texture *texture,
+    float scrollPos,
+    DrawStats &stats);
+void drawScene(
+    const SDLState &state,
+    GameState &gs,
+    Resources &res,
+    float deltaTime,
+    DirtyRegions *dirty);
+void renderScene(
+    const SDLState &state,
+    GameState &gs,
+    Resources &res,
+    const SDL_Rect *region);
 
 void loadMap(
     const SDLState &state,
@@ -224,9 +466,8 @@ void handleShooting(
     GameState &gs,
     Resources &res,
     GameObject &obj,
-    Timer &weaponTimer,
-    SDL_Texture *texture,
-    SDL_Texture *shootingTexture,
+    TextureHandle texture,
+    TextureHandle shootingTexture,
     int animIndex,
     int shootAnimIndex);
 
@@ -236,41 +477,144 @@ void genericCollisionResponse(
     SDL_FRect &rectA,
     SDL_FRect &rectB,
     SDL_FRect &rectC);
+void scriptAllocTestInput(bool keys[], uint64_t frame);
+int characterIndex(GameState &gs, GameObject &obj);
+float soundPan(const GameState &gs, const GameObject &obj);
+void setAnimation(GameState &gs, Resources &res, GameObject &obj, int anim);
+void stopAnimation(GameState &gs, GameObject &obj, int spriteFrame);
+void onWeaponReady(void *context, int index);
+void onFlashOver(void *context, int index);
+int navNodeAt(const SDLState &state, GameState &gs, const GameObject &obj);
+float steerEnemy(const SDLState &state, GameState &gs, GameObject &obj);
+Behavior enemyBehavior(const SDLState &state, GameState &gs, Resources &res, int index);
+void startEnemyBehaviors(const SDLState &state, GameState &gs, Resources &res);
+void simulate(
+    SDLState &state,
+    GameState &gs,
+    Resources &res,
+    const FrameInput &input,
+    bool replayKeys[]);
+uint64_t simulationHash(GameState &gs);
+const char *describeState(GameState &gs);
 
 int main(int argc, char *argv[]) {
-    (void)argc;
-    (void)argv;
+    GameOptions options = parseOptions(argc, argv);
+    if (options.benchFrames > 0) {
+        return runBenchmark(options);
+    }
 
     SDLState state;
 
-    if (!initialize(state)) {
+    if (!initialize(state, options.software ? "software" : NULL)) {
         std::cerr << "Failed to initialize: " << SDL_GetError() << std::endl;
         return 1;
     }
 
+    // the game is drawn into this at its logical size, then scaled up to the window once
+    ScreenTarget screen;
+    if (!screen.init(state.renderer, state.logW, state.logH)) {
+        std::cerr << "Failed to create the screen target: " << SDL_GetError()
+                  << std::endl;
+        cleanup(state);
+        return 1;
+    }
+
     // load game assets
     Resources res;
-    res.load(state);
+    res.load(state, options);
 
     // setup game data
     // keys is used to know which keys are being pressed in our program
-    GameState gs = GameState(state);
+    GameState gs(state);
     createTiles(state, gs, res);
+    startEnemyBehaviors(state, gs, res);
+
+    FramePacer pacer;
+    pacer.setTargetFps(options.targetFps);
+    pacer.setMode(state.renderer, options.pacingMode);
+
+    // --alloc-test plays by itself, we replace SDL's keyboard state with our own keys
+    static bool scriptedKeys[SDL_SCANCODE_COUNT] = {};
+    if (options.allocTestFrames > 0) {
+        state.keys = scriptedKeys;
+    }
+    int allocatingFrames = 0;
+
+    // the last frames for rewinding (R) and rollback, plus a checkpoint for instant
+    // retries (F5 saves it, F9 goes back to it)
+    SnapshotHistory<FrameInput> history;
+    history.init(HISTORY_FRAMES, SNAPSHOT_RESERVE);
+    Snapshot checkpoint;
+    checkpoint.reserve(SNAPSHOT_RESERVE);
+    gs.save(checkpoint);
+    static bool replayKeys[SDL_SCANCODE_COUNT] = {};
+    uint64_t saveNs = 0, restoreNs = 0;
 
-    uint64_t previousTime = SDL_GetTicks();
+    HitchRecorder hitches;
+    hitches.init(options.hitchMs, HITCH_LOG_PATH);
+
+    // the lines of the debug overlay
+    HudLayer debugHud;
+    SDL_Color debugTextColor = {10, 0, 0, 255};
+    debugHud.init(DEBUG_HUD_LINES, debugTextColor, 10);
+
+    // --dirty-rects
+    DirtyRegions dirty;
+    dirty.init(state.logW, state.logH);
+
+    uint64_t previousTime = SDL_GetTicksNS();
+    uint64_t frame = 0;
 
     std::cout << "Window created successfully. Press ESC or close window to exit."
               << std::endl;
     bool running = true;
     SDL_Event event;
     while (running) {
-        uint64_t now = SDL_GetTicks();
-        // note get ticks is in milisecond and we want to work with seconds in this
-        // engine, so we divide by a thousand, because 1000ms = 1s
-        float deltaTime = (now - previousTime) / 1000.0f;
+        uint64_t now = SDL_GetTicksNS();
+        // note get ticks is in nanoseconds and we want to work with seconds in this
+        // engine. milliseconds aren't precise enough anymore, at 144hz a frame is 6.94ms
+        float deltaTime = static_cast<float>(now - previousTime) / SDL_NS_PER_SECOND;
         previousTime = now;
+        pacer.record(deltaTime);
+
+        AllocTracker::beginFrame();
+        gs.profiler.beginFrame(frame);
+        gs.beginFrame();
+        res.textures.beginFrame();
+        // deltaTime is how long the last frame took
+        if (hitches.isHitch(deltaTime)) {
+            hitches.save(gs.profiler.lastFrame(), deltaTime, describeState(gs));
+        }
+        if (options.allocTestFrames > 0) {
+            if (frame > ALLOC_TEST_WARMUP_FRAMES &&
+                AllocTracker::lastFrameTotal().allocations > 0) {
+                allocatingFrames++;
+                std::cerr << "Frame " << frame - 1 << " allocated:";
+                for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+                    AllocCounters counters = AllocTracker::lastFrame(AllocTag(i));
+                    if (counters.allocations) {
+                        std::cerr << " " << AllocTracker::getTagName(AllocTag(i)) << " "
+                                  << counters.allocations << " (" << counters.bytes
+                                  << " bytes)";
+                    }
+                }
+                std::cerr << std::endl;
+            }
+            if (frame > static_cast<uint64_t>(
+                            ALLOC_TEST_WARMUP_FRAMES + options.allocTestFrames)) {
+                running = false;
+            }
+            scriptAllocTestInput(scriptedKeys, frame);
+        }
+        frame++;
 
         // first check for events
+        gs.profiler.enter(AllocTag::INPUT);
+        FrameInput input;
+        input.deltaTime = deltaTime;
+        input.jump = false;
+        bool loadCheckpoint = false;
+        bool rollbackTest = false;
         while (SDL_PollEvent(&event)) {
             switch (event.type) {
             case SDL_EVENT_QUIT: {
@@ -280,19 +624,53 @@ int main(int argc, char *argv[]) {
             case SDL_EVENT_WINDOW_RESIZED: {
                 state.width = event.window.data1;
                 state.height = event.window.data2;
+                dirty.invalidate();
                 break;
             }
             case SDL_EVENT_KEY_DOWN: {
                 if (event.key.key == SDLK_ESCAPE) {
                     running = false;
                 }
-                handleKeyInput(state, gs, gs.player(), event.key.scancode, true);
+                // the player reacts to it in simulate(), so replays can do the same
+                if (event.key.scancode == SDL_SCANCODE_SPACE) {
+                    input.jump = true;
+                }
                 break;
             }
             case SDL_EVENT_KEY_UP: {
-                handleKeyInput(state, gs, gs.player(), event.key.scancode, false);
                 if (event.key.scancode == SDL_SCANCODE_BACKSLASH) {
                     gs.debugMode = !gs.debugMode;
+                    // the overlay has to be erased, or drawn over all of it
+                    dirty.invalidate();
+                    debugHud.invalidate();
+                }
+                if (event.key.scancode == SDL_SCANCODE_F1) {
+                    pacer.cycleMode(state.renderer);
+                }
+                if (event.key.scancode == SDL_SCANCODE_F2) {
+                    // stress test, a few presses gets us to 100k particles
+                    ParticleEmitter burst = EMITTER_ENEMY_DEATH;
+                    burst.count = 20000;
+                    burst.minLife = 3;
+                    burst.maxLife = 6;
+                    burst.gravity = 50;
+                    gs.particles.emit(
+                        burst,
+                        gs.player().position.x + 32,
+                        gs.player().position.y + 32,
+                        1);
+                }
+                if (event.key.scancode == SDL_SCANCODE_F3) {
+                    res.textures.printReport(std::cout);
+                }
+                if (event.key.scancode == SDL_SCANCODE_F5) {
+                    gs.save(checkpoint);
+                }
+                if (event.key.scancode == SDL_SCANCODE_F9) {
+                    loadCheckpoint = true;
+                }
+                if (event.key.scancode == SDL_SCANCODE_F6) {
+                    rollbackTest = true;
                 }
                 break;
             }
@@ -300,138 +678,282 @@ int main(int argc, char *argv[]) {
         }
 
         // handle the events (update)
-        for (std::vector<GameObject> &layer : gs.layers) {
-            for (GameObject &obj : layer) {
-                update(state, gs, res, obj, deltaTime);
-            }
-        }
+        gs.profiler.enter(AllocTag::UPDATE);
 
-        // update bullets
-
-        for (GameObject &obj : gs.bullets) {
-            assert(obj.type == ObjectType::BULLET);
-            update(state, gs, res, obj, deltaTime);
+        if (loadCheckpoint) {
+            gs.restore(checkpoint);
+            startEnemyBehaviors(state, gs, res);
+            // the frames before it don't lead here anymore
+            history.clear();
         }
 
-        // calculate viewport / camera position
-        gs.mapViewport.x = (gs.player().position.x + static_cast<float>(TILE_SIZE) / 2) -
-                           gs.mapViewport.w / 2;
-
-        // perform drawing commands at last
-        SDL_SetRenderDrawColor(state.renderer, 20, 0, 0, 255);
-        SDL_RenderClear(state.renderer);
-
-        // draw background images
-        SDL_RenderTexture(state.renderer, res.bg1Texture, NULL, NULL);
-        drawParallaxBackground(
-            state,
-            res.bg5Texture,
-            gs.player().velocity.x,
-            gs.bg5Scroll,
-            0.0375f,
-            deltaTime);
-
-        drawParallaxBackground(
-            state,
-            res.bg4Texture,
-            gs.player().velocity.x,
-            gs.bg4Scroll,
-            0.075f,
-            deltaTime);
-
-        drawParallaxBackground(
-            state,
-            res.bg3Texture,
-            gs.player().velocity.x,
-            gs.bg3Scroll,
-            0.150f,
-            deltaTime);
-
-        drawParallaxBackground(
-            state,
-            res.bg2Texture,
-            gs.player().velocity.x,
-            gs.bg2Scroll,
-            0.3f,
-            deltaTime);
-
-        // draw background tiles before regular objects
-        for (GameObject &obj : gs.backgroundTiles) {
-            SDL_FRect dest{
-                obj.position.x - gs.mapViewport.x,
-                obj.position.y,
-                static_cast<float>(obj.texture->w),
-                static_cast<float>(obj.texture->h)};
-            SDL_RenderTexture(state.renderer, obj.texture, NULL, &dest);
+        if (state.keys[SDL_SCANCODE_R] && history.size() > 0) {
+            // rewinding, the frames go by backwards instead of simulating
+            uint64_t restoreStart = SDL_GetTicksNS();
+            gs.restore(history.state(0));
+            startEnemyBehaviors(state, gs, res);
+            restoreNs = SDL_GetTicksNS() - restoreStart;
+            history.pop();
+        } else {
+            input.left = state.keys[SDL_SCANCODE_A];
+            input.right = state.keys[SDL_SCANCODE_D];
+            input.shoot = state.keys[SDL_SCANCODE_J];
+
+            uint64_t saveStart = SDL_GetTicksNS();
+            gs.save(history.push());
+            saveNs = SDL_GetTicksNS() - saveStart;
+            history.setLatestInput(input);
+
+            simulate(state, gs, res, input, NULL);
         }
 
-        // draw all objects
-        for (std::vector<GameObject> &layer : gs.layers) {
-            for (GameObject &obj : layer) {
-                float srcSize = TILE_SIZE;
-                float destSize = TILE_SIZE;
-                if (obj.type == ObjectType::PLAYER) {
-                    srcSize = 256;
-                    destSize = 64;
-                } else if (obj.type == ObjectType::ENEMY) {
-                    srcSize = 128;
-                    destSize = 128;
-                }
-                drawObject(state, gs, obj, srcSize, destSize, deltaTime);
+        gs.particles.update(deltaTime);
+
+        if (rollbackTest && history.size() >= ROLLBACK_TEST_FRAMES) {
+            // what rollback netcode does when a late input arrives: go back, simulate
+            // the frames again, and we must end up exactly where we are now
+            uint64_t rollbackStart = SDL_GetTicksNS();
+            uint64_t expected = simulationHash(gs);
+            gs.restore(history.state(ROLLBACK_TEST_FRAMES - 1));
+            startEnemyBehaviors(state, gs, res);
+            res.audio.setMuted(true);
+            gs.particles.setEnabled(false);
+            for (int i = ROLLBACK_TEST_FRAMES - 1; i >= 0; i--) {
+                gs.beginFrame();
+                simulate(state, gs, res, history.input(i), replayKeys);
             }
+            res.audio.setMuted(false);
+            gs.particles.setEnabled(true);
+            bool matches = simulationHash(gs) == expected;
+            std::cout << "Rollback of " << ROLLBACK_TEST_FRAMES << " frames took "
+                      << (SDL_GetTicksNS() - rollbackStart) / 1000.0 << "us, the state "
+                      << (matches ? "matches" : "DIFFERS") << std::endl;
         }
 
-        // draw bullets
-        for (GameObject &bullet : gs.bullets) {
-            assert(bullet.type == ObjectType::BULLET);
-
-            if (bullet.data.bullet.state == BulletState::INACTIVE) {
-                // dont render inactive bullets
-                continue;
-            }
-
-            drawObject(
-                state,
-                gs,
-                bullet,
-                bullet.collider.w,
-                bullet.collider.h,
-                deltaTime);
-        }
-
-        // draw foreground objects
-        for (GameObject &obj : gs.foregroundTiles) {
-            SDL_FRect dest{
-                obj.position.x - gs.mapViewport.x,
-                obj.position.y,
-                static_cast<float>(obj.texture->w),
-                static_cast<float>(obj.texture->h)};
-            SDL_RenderTexture(state.renderer, obj.texture, NULL, &dest);
-        }
+        // perform drawing commands at last
+        gs.profiler.enter(AllocTag::DRAW);
+        screen.begin(state.renderer);
+        drawScene(state, gs, res, deltaTime, options.dirtyRects ? &dirty : NULL);
 
-        // display some debug info
-        if (gs.debugMode) {
-            SDL_SetRenderDrawColor(state.renderer, 10, 0, 0, 255);
-            SDL_RenderDebugText(
+        // display some debug info, formatted a few times per second, see HudLayer
+        if (gs.debugMode && debugHud.beginRefresh(deltaTime)) {
+            debugHud.setLine(
                 state.renderer,
-                8,
-                8,
+                0,
                 formatText(
-                    "State: %d, Bullets: %d, Grounded: %d",
+                    gs.frameArena,
+                    "State: %d, Bullets: %d, Grounded: %d, Pairs: %d checked, %d skipped",
                     gs.player().data.player.state,
                     gs.bullets.size(),
-                    gs.player().grounded));
+                    gs.player().grounded,
+                    gs.collisionChecks,
+                    gs.collisionSkips));
+
+            const FrameTimeStats &frameStats = pacer.getStats();
+            debugHud.setLine(
+                state.renderer,
+                1,
+                formatText(
+                    gs.frameArena,
+                    "Pacing: %s %d, Frame: %.2fms +/- %.3fms, Scale: %gx",
+                    pacer.getModeName(),
+                    pacer.getTargetFps(),
+                    frameStats.mean() * 1000,
+                    frameStats.stdDev() * 1000,
+                    screen.getScale()));
+
+            AllocCounters allocs = AllocTracker::lastFrameTotal();
+            debugHud.setLine(
+                state.renderer,
+                2,
+                formatText(
+                    gs.frameArena,
+                    "Allocs: %llu (%llu B) input %llu, update %llu, shooting %llu, draw "
+                    "%llu",
+                    (unsigned long long)allocs.allocations,
+                    (unsigned long long)allocs.bytes,
+                    (unsigned long long)AllocTracker::lastFrame(AllocTag::INPUT)
+                        .allocations,
+                    (unsigned long long)AllocTracker::lastFrame(AllocTag::UPDATE)
+                        .allocations,
+                    (unsigned long long)AllocTracker::lastFrame(AllocTag::SHOOTING)
+                        .allocations,
+                    (unsigned long long)AllocTracker::lastFrame(AllocTag::DRAW)
+                        .allocations));
+
+            debugHud.setLine(
+                state.renderer,
+                3,
+                formatText(
+                    gs.frameArena,
+                    "Arena: %zu/%zu KB (peak %zu KB, overflow %zu B), Contacts: %zu, "
+                    "Timers: %d",
+                    gs.frameArena.getUsed() / 1024,
+                    gs.frameArena.getCapacity() / 1024,
+                    gs.frameArena.getPeak() / 1024,
+                    gs.frameArena.getOverflow(),
+                    gs.contacts.size(),
+                    gs.timers.getPendingCount()));
+
+            AudioStats audioStats = res.audio.getStats();
+            debugHud.setLine(
+                state.renderer,
+                4,
+                formatText(
+                    gs.frameArena,
+                    "Audio: %d voices, mix %.1fus (peak %.1fus), underruns %llu, dropped "
+                    "%llu",
+                    audioStats.activeVoices,
+                    audioStats.mixTimeAvgUs,
+                    audioStats.mixTimePeakUs,
+                    (unsigned long long)audioStats.underruns,
+                    (unsigned long long)audioStats.droppedCommands));
+
+            debugHud.setLine(
+                state.renderer,
+                5,
+                formatText(
+                    gs.frameArena,
+                    "Textures: %d/%d resident, %.1f/%zu MB, loads %llu, evictions %llu",
+                    res.textures.getResidentCount(),
+                    res.textures.getCount(),
+                    res.textures.getResidentBytes() / (1024.0 * 1024.0),
+                    res.textures.getBudgetBytes() / (1024 * 1024),
+                    (unsigned long long)res.textures.getLoads(),
+                    (unsigned long long)res.textures.getEvictions()));
+
+            debugHud.setLine(
+                state.renderer,
+                6,
+                formatText(
+                    gs.frameArena,
+                    "Nav: %d nodes, %d links, target %d, queries %llu, searches %llu",
+                    gs.nav.getNodeCount(),
+                    gs.nav.getLinkCount(),
+                    gs.navTarget,
+                    (unsigned long long)gs.nav.getQueries(),
+                    (unsigned long long)gs.nav.getSearches()));
+
+            debugHud.setLine(
+                state.renderer,
+                7,
+                formatText(
+                    gs.frameArena,
+                    "Particles: %d/%d, update %.2fms, draw %.2fms (F2 adds 20k)",
+                    gs.particles.getCount(),
+                    MAX_PARTICLES,
+                    gs.particles.getUpdateNs() / 1e6,
+                    gs.particles.getDrawNs() / 1e6));
+
+            debugHud.setLine(
+                state.renderer,
+                8,
+                formatText(
+                    gs.frameArena,
+                    "Snapshot: %zu B, save %.1fus, restore %.1fus, history %d/%d frames",
+                    history.size() > 0 ? history.state(0).size() : checkpoint.size(),
+                    saveNs / 1000.0,
+                    restoreNs / 1000.0,
+                    history.size(),
+                    history.capacity()));
+
+            const FrameTimeHistogram &histogram = pacer.getHistogram();
+            debugHud.setLine(
+                state.renderer,
+                9,
+                formatText(
+                    gs.frameArena,
+                    "Frames: p50 %.2fms, p95 %.2fms, p99 %.2fms, p99.9 %.2fms",
+                    histogram.percentile(0.5) * 1000,
+                    histogram.percentile(0.95) * 1000,
+                    histogram.percentile(0.99) * 1000,
+                    histogram.percentile(0.999) * 1000));
+
+            // its own line, the overlay is 640 pixels wide and that's 79 characters
+            debugHud.setLine(
+                state.renderer,
+                10,
+                formatText(
+                    gs.frameArena,
+                    "Slowest: %.2fms, hitches %d",
+                    histogram.max() * 1000,
+                    hitches.getHitches()));
+
+            debugHud.setLine(
+                state.renderer,
+                11,
+                formatText(
+                    gs.frameArena,
+                    "AI: %d behaviors, %d resumed, %d conditions checked",
+                    gs.behaviors.getRunning(),
+                    gs.behaviors.getResumed(),
+                    gs.behaviors.getPolled()));
+        }
+        if (gs.debugMode) {
+            debugHud.draw(state.renderer, 8, 8);
+        }
+        // a partial frame only changed the dirty regions, the window gets only those
+        if (options.dirtyRects && dirty.isPartial()) {
+            screen.presentRegions(state.renderer, dirty.getRegions());
+        } else {
+            screen.present(state.renderer);
         }
         // swab buffers and present
         SDL_RenderPresent(state.renderer);
+        gs.profiler.enter(AllocTag::OTHER);
+
+        pacer.wait();
+    }
+
+    // useful when running with --uncapped to compare performance between builds
+    const FrameTimeStats &frameStats = pacer.getStats();
+    std::cout << "Frame time (" << pacer.getModeName() << "): mean "
+              << frameStats.mean() * 1000 << "ms, std dev " << frameStats.stdDev() * 1000
+              << "ms, variance " << frameStats.variance() * 1000 * 1000 << "ms^2"
+              << std::endl;
+    const FrameTimeHistogram &histogram = pacer.getHistogram();
+    std::cout << "Frame time percentiles (last " << histogram.getCount()
+              << " frames): p50 " << histogram.percentile(0.5) * 1000 << "ms, p95 "
+              << histogram.percentile(0.95) * 1000 << "ms, p99 "
+              << histogram.percentile(0.99) * 1000 << "ms, p99.9 "
+              << histogram.percentile(0.999) * 1000 << "ms, max "
+              << histogram.max() * 1000 << "ms" << std::endl;
+    if (hitches.getHitches() > 0) {
+        std::cout << hitches.getHitches() << " frames over " << options.hitchMs
+                  << "ms, written to " << hitches.getPath() << std::endl;
+    }
+
+    if (options.dirtyRects) {
+        std::cout << "Dirty rects: " << dirty.getPartialFrames() << " partial frames ("
+                  << dirty.getPartialCoverage() * 100 << "% of the screen on average), "
+                  << dirty.getFullFrames() << " full frames" << std::endl;
     }
 
+    AudioStats audioStats = res.audio.getStats();
+    std::cout << "Audio mix (" << audioStats.blocksMixed << " blocks): mean "
+              << audioStats.mixTimeAvgUs << "us, peak " << audioStats.mixTimePeakUs
+              << "us, underruns " << audioStats.underruns << ", dropped commands "
+              << audioStats.droppedCommands << std::endl;
+
+    debugHud.destroy();
+    screen.destroy();
     res.unload();
     cleanup(state);
+
+    if (options.allocTestFrames > 0) {
+        if (allocatingFrames > 0) {
+            std::cerr << "Alloc test failed: " << allocatingFrames << " of "
+                      << options.allocTestFrames << " frames allocated" << std::endl;
+            return 1;
+        }
+        std::cout << "Alloc test passed: " << options.allocTestFrames
+                  << " frames without allocations" << std::endl;
+    }
     return 0;
 }
 
-bool initialize(SDLState &state) {
+// `rendererName` NULL lets SDL pick the best one
+bool initialize(SDLState &state, const char *rendererName) {
 
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
@@ -452,32 +974,45 @@ bool initialize(SDLState &state) {
         return false;
     }
 
-    state.renderer = SDL_CreateRenderer(state.window, NULL);
+    state.renderer = SDL_CreateRenderer(state.window, rendererName);
     if (!state.renderer) {
         std::cerr << "SDL_CreateRenderer failed: " << SDL_GetError() << std::endl;
         cleanup(state);
         return false;
     }
 
-    // enable vsync (this could be a setting in the menu?)
-    // avoids having the game running freely with unlimited fps
-    SDL_SetRenderVSync(state.renderer, 1);
+    // vsync is not enabled here, the FramePacer decides it based on the pacing mode
 
-    // configure presentation, this makes the game be rendered at a logical size that we
-    // define, so that the game is scaled accordingly without us having to worry about
-    // scaling objects, it also makes the size be respected without caring about the real
-    // window size
-    //
-    // In short: allows us to work in a resolution independent from the window size /
-    // monitor resolution PRESENTATION_LETTERBOX = "create black bars around the game"
-    //
+    // the logical size is the resolution we work in, independent from the window size /
+    // monitor resolution. the game is drawn at this size and scaled up with black bars
+    // around it, see ScreenTarget
     state.logW = 640;
     state.logH = 320;
-    SDL_SetRenderLogicalPresentation(
-        state.renderer,
-        state.logW,
-        state.logH,
-        SDL_LOGICAL_PRESENTATION_LETTERBOX);
+    return true;
+}
+
+// no window and no GPU: a software renderer drawing into a surface in memory, so we can
+// measure the draw pass on machines without either. the surface has the logical size,
+// it's what the ScreenTarget texture would be in the game
+bool initializeOffscreen(SDLState &state, SDL_Surface *&target) {
+    // nobody's listening, and build machines may not have a sound card
+    SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+
+    state.window = NULL;
+    state.width = state.logW = 640;
+    state.height = state.logH = 320;
+
+    target = SDL_CreateSurface(state.logW, state.logH, SDL_PIXELFORMAT_XRGB8888);
+    if (!target) {
+        std::cerr << "SDL_CreateSurface failed: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    state.renderer = SDL_CreateSoftwareRenderer(target);
+    if (!state.renderer) {
+        std::cerr << "SDL_CreateSoftwareRenderer failed: " << SDL_GetError() << std::endl;
+        SDL_DestroySurface(target);
+        return false;
+    }
     return true;
 }
 
@@ -488,21 +1023,19 @@ void cleanup(SDLState &state) {
 }
 
 void drawObject(
-    const SDLState &state,
     GameState &gs,
+    Resources &res,
     GameObject &obj,
     float srcSize,
-    float destSize,
-    float deltaTime) {
+    float destSize) {
 
     // move the sprite position
-    // if current animation is set we keep animating, else we use the sprite frame set on
-    // the game object
-    float srcX = obj.currentAnimation != -1
-                     ? obj.animations[obj.currentAnimation].currentFrame() * srcSize
-                     : (obj.spriteFrame - 1) * srcSize;
-
-    SDL_FRect srcRect = {srcX, 0, srcSize, srcSize};
+    // animated objects read the source rect the animation system computed for this
+    // frame, else we use the sprite frame set on the game object
+    SDL_FRect srcRect = {(obj.spriteFrame - 1) * srcSize, 0, srcSize, srcSize};
+    if (obj.animation != -1) {
+        srcRect = gs.animations.getSrcRect(obj.animation);
+    }
 
     // the viewport applied here shifts the position of where things are drawn on the
     // screen. note that we don't mess with the obj actual position in the world, but with
@@ -517,33 +1050,16 @@ void drawObject(
         destSize,
         destSize};
 
-    if (!obj.shouldFlash) {
-        SDL_RenderTextureRotated(
-            state.renderer,
-            obj.texture,
-            &srcRect,
-            &destRect,
-            0,
-            NULL,
-            obj.direction == 1 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL);
-
-    } else {
-        // flash objecta with a redish tint,brighten or disaturate the color
-        SDL_SetTextureColorModFloat(obj.texture, 2.5f, 1.0f, 1.0f);
-        SDL_RenderTextureRotated(
-            state.renderer,
-            obj.texture,
-            &srcRect,
-            &destRect,
-            0,
-            NULL,
-            obj.direction == 1 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL);
-        SDL_SetTextureColorModFloat(obj.texture, 1.0f, 1.0f, 1.0f);
-
-        if (obj.flashTimer.step(deltaTime)) {
-            obj.shouldFlash = false;
-        }
-    }
+    DrawCommand cmd;
+    cmd.texture = res.textures.get(obj.texture);
+    cmd.srcRect = srcRect;
+    cmd.destRect = destRect;
+    cmd.flip = obj.direction == 1 ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL;
+    // flash objecta with a redish tint,brighten or disaturate the color
+    cmd.flash = obj.shouldFlash;
+    // static bodies never move, they look the same every frame
+    cmd.dynamic = !obj.staticBody;
+    gs.drawList.push_back(cmd);
 
     if (gs.debugMode) {
         SDL_FRect colliderDebugRect{
@@ -552,9 +1068,31 @@ void drawObject(
             obj.collider.w,
             obj.collider.h,
         };
-        SDL_SetRenderDrawColor(state.renderer, 255, 0, 0, 122);
-        SDL_RenderRect(state.renderer, &colliderDebugRect);
+        gs.debugRects.push_back(colliderDebugRect);
+    }
+}
+
+// tiles are drawn whole, at their texture size
+void drawTile(GameState &gs, Resources &res, GameObject &obj) {
+    DrawCommand cmd;
+    cmd.texture = res.textures.get(obj.texture);
+    if (!cmd.texture) {
+        return;
     }
+    cmd.srcRect = {
+        0,
+        0,
+        static_cast<float>(cmd.texture->w),
+        static_cast<float>(cmd.texture->h)};
+    cmd.destRect = {
+        obj.position.x - gs.mapViewport.x,
+        obj.position.y,
+        static_cast<float>(cmd.texture->w),
+        static_cast<float>(cmd.texture->h)};
+    cmd.flip = SDL_FLIP_NONE;
+    cmd.flash = false;
+    cmd.dynamic = false;
+    gs.drawList.push_back(cmd);
 }
 
 void update(
@@ -564,17 +1102,10 @@ void update(
     GameObject &obj,
     float deltaTime) {
 
-    // update the animation
-    //
-    // step animation
-    if (obj.currentAnimation != -1) {
-        obj.animations[obj.currentAnimation].step(deltaTime);
-    }
-
     // apply gravity to dynamic objects
     if (obj.dynamic && !obj.grounded) {
         obj.velocity +=
-            glm::vec2(0, 2000.0f) * deltaTime; // apply downward force to objects
+            glm::vec2(0, GRAVITY) * deltaTime; // apply downward force to objects
     }
 
     // 0 means pressing neither A or D or BOTH
@@ -595,9 +1126,6 @@ void update(
         // .. if both are pressed it becomes 0, and the character doesn't walk, because it
         // subtracts 1 (A-left) and then sums 1 (D-right)
 
-        Timer &weaponTimer = obj.data.player.weaponTimer;
-        weaponTimer.step(deltaTime);
-
         PlayerState &playerState = obj.data.player.state;
         switch (playerState) {
         case PlayerState::IDLE: {
@@ -633,7 +1161,6 @@ void update(
                 gs,
                 res,
                 obj,
-                weaponTimer,
                 res.idleTexture,
                 res.shootingTexture,
                 res.ANIM_PLAYER_IDLE,
@@ -650,16 +1177,16 @@ void update(
             // us to go right, direction defines where we going, if left -1 if right 1
             if (obj.direction * obj.velocity.x < 0) {
                 obj.texture = res.slideTexture;
-                obj.currentAnimation = res.ANIM_PLAYER_SLIDE;
+                setAnimation(gs, res, obj, res.ANIM_PLAYER_SLIDE);
             } else {
                 obj.texture = res.walkTexture;
-                obj.currentAnimation = res.ANIM_PLAYER_WALK;
+                setAnimation(gs, res, obj, res.ANIM_PLAYER_WALK);
             }
             break;
         }
         case PlayerState::JUMPING: {
             obj.texture = res.jumpTexture;
-            obj.currentAnimation = res.ANIM_PLAYER_JUMP;
+            setAnimation(gs, res, obj, res.ANIM_PLAYER_JUMP);
         }
         }
     } else if (obj.type == ObjectType::BULLET) {
@@ -682,65 +1209,18 @@ void update(
             // 💡 this creates a nice animation effect, we wait for the animation to
             // finish, then sets do inactive, setting to inactive means we no longer
             // render on the screen
-            if (obj.animations[obj.currentAnimation].isDone()) {
+            if (gs.animations.isDone(obj.animation)) {
                 obj.data.bullet.state = BulletState::INACTIVE;
             }
         }
         }
     } else if (obj.type == ObjectType::ENEMY) {
-        switch (obj.data.enemy.state) {
-        case EnemyState::IDLE: {
-            obj.currentAnimation = res.ANIM_ENEMY_IDLE;
-            obj.texture = res.enemyIdleTexture;
-            // 💡 enemy AI  in idle and walking state so that it get "aggroed" by the
-            // player whenever the player is close enough
-
-            glm::vec2 playerDir = gs.player().position - obj.position;
-            // check if player is close, starts walking
-            if (glm::length(playerDir) < 200) {
-                obj.data.enemy.state = EnemyState::WALKING;
-            } else {
-                obj.acceleration = glm::vec2(0);
-                obj.velocity.x = 0;
-            }
-            break;
-        }
-        case EnemyState::WALKING: {
-            obj.currentAnimation = res.ANIM_ENEMY_WALK;
-            obj.texture = res.enemyWalkTexture;
-            glm::vec2 playerDir = gs.player().position - obj.position;
-            // check if player is close, starts walking
-            if (glm::length(playerDir) < 400) {
-                currentDirection = playerDir.x < 0 ? -1 : 1;
-                obj.acceleration = glm::vec2(100, 0);
-            } else {
-                obj.data.enemy.state = EnemyState::IDLE;
-            }
-            break;
-        }
-        case EnemyState::DAMAGED: {
-            obj.acceleration = glm::vec2(0);
-            obj.velocity.x = 0;
-
-            // obj.acceleration = glm::vec2(0);
-            if (obj.data.enemy.damagedTimer.step(deltaTime)) {
-                obj.data.enemy.state = EnemyState::IDLE;
-                obj.texture = res.enemyIdleTexture;
-                obj.currentAnimation = res.ANIM_ENEMY_IDLE;
-            }
-            break;
-        }
-        case EnemyState::DEAD: {
-            obj.velocity.x = 0;
-            if (obj.currentAnimation != -1 &&
-                obj.animations[obj.currentAnimation].isDone()) {
-                // 💡 to stop an animation set to -1
-                //  remove animation and set to the last sprite of the spritesheet
-                obj.currentAnimation = -1;
-                obj.spriteFrame = 4;
-            }
-            break;
-        }
+        // enemyBehavior() decides where to go. mid-jump it goes where the jump takes
+        // it, the velocity was set when jumping, see steerEnemy()
+        if (obj.data.enemy.state == EnemyState::JUMPING) {
+            currentDirection = obj.velocity.x < 0 ? -1 : 1;
+        } else {
+            currentDirection = obj.data.enemy.steering;
         }
     }
 
@@ -751,7 +1231,10 @@ void update(
     // accelerates the character by pressing keys
     obj.velocity += currentDirection * (obj.acceleration * deltaTime);
 
-    if (std::abs(obj.velocity.x) > obj.maxSpeedX) {
+    // 💡 jumps need more than the walking speed to make it across
+    bool navJump =
+        obj.type == ObjectType::ENEMY && obj.data.enemy.state == EnemyState::JUMPING;
+    if (!navJump && std::abs(obj.velocity.x) > obj.maxSpeedX) {
         obj.velocity.x = currentDirection * obj.maxSpeedX;
     }
 
@@ -768,7 +1251,14 @@ void update(
             // make sure they're different by checking their memory address
             // we don't want to check if it's colliding against itself
             if (&obj != &objB) {
-                checkCollision(state, gs, res, obj, objB, deltaTime);
+                // 💡 one AND rejects the pairs that can't do anything to each other
+                // (level with level, enemy with enemy...) before we touch their rects
+                if (obj.reactsTo(objB)) {
+                    checkCollision(state, gs, res, obj, objB, deltaTime);
+                    gs.collisionChecks++;
+                } else {
+                    gs.collisionSkips++;
+                }
 
                 if (objB.type == ObjectType::LEVEL) {
                     // grounded sensor, this creates a pixel line that is at the bottom of
@@ -801,6 +1291,19 @@ void update(
         if (foundGround && obj.type == ObjectType::PLAYER) {
             obj.data.player.state = PlayerState::WALKING;
         }
+        if (foundGround && navJump) {
+            obj.data.enemy.state = EnemyState::WALKING;
+        }
+        // only characters land, bullets hitting a wall don't kick up dust
+        bool isCharacter =
+            obj.type == ObjectType::PLAYER || obj.type == ObjectType::ENEMY;
+        if (foundGround && isCharacter) {
+            gs.particles.emit(
+                EMITTER_LANDING,
+                obj.position.x + obj.collider.x + obj.collider.w / 2,
+                obj.position.y + obj.collider.y + obj.collider.h,
+                obj.direction);
+        }
     }
 }
 
@@ -809,9 +1312,9 @@ GameObject createObject(
     int row,
     int col,
     ObjectType type,
-    SDL_Texture *texture) {
+    TextureHandle texture) {
     GameObject obj;
-    obj.type = type;
+    obj.setType(type);
     obj.texture = texture;
     obj.position = glm::vec2(col * TILE_SIZE, state.logH - (MAP_ROWS - row) * TILE_SIZE);
     obj.collider = {0, 0, TILE_SIZE, TILE_SIZE};
@@ -882,6 +1385,7 @@ void collisionResponse(
         case BulletState::MOVING: {
             switch (objB.type) {
             case ObjectType::LEVEL: {
+                res.audio.play(AudioClip::BULLET_HIT, 0.5f, soundPan(gs, objA));
                 break;
             }
             case ObjectType::ENEMY: {
@@ -891,22 +1395,39 @@ void collisionResponse(
                     // ⚠️ i'd like to have events, like "bullet collided" and then the game
                     // object could listen to it and then perform this actions, this is
                     // very coupled and easy to make bugs
+                    const int index = characterIndex(gs, objB);
                     data.state = EnemyState::DAMAGED;
-                    objB.currentAnimation = res.ANIM_ENEMY_HIT;
+                    setAnimation(gs, res, objB, res.ANIM_ENEMY_HIT);
                     objB.texture = res.enemyHitTexture;
+                    // getting hit again restarts the timers
+                    gs.timers.cancel(data.wakeTimer);
                     objB.shouldFlash = true;
-                    objB.flashTimer.reset();
+                    gs.timers.cancel(objB.flashTimer);
+                    objB.flashTimer =
+                        gs.timers.schedule(FLASH_TIME, onFlashOver, &gs, index);
                     // bullet damage
                     data.health -= 10;
-                    if (data.health <= 0) {
+                    if (data.health > 0) {
+                        res.audio.play(AudioClip::ENEMY_HIT, 1.0f, soundPan(gs, objB));
+                    } else {
                         // ⚠️ here we probably should have a property "active" in the
                         // GameObject struct, so that we could set that to true and we
                         // wouldnt execute anything after active is false, maybe after the
                         // dead animation is ended though
                         data.state = EnemyState::DEAD;
+                        gs.particles.emit(
+                            EMITTER_ENEMY_DEATH,
+                            rectB.x + rectB.w / 2,
+                            rectB.y + rectB.h / 2,
+                            objB.direction);
                         objB.texture = res.enemyDeadTexture;
-                        objB.currentAnimation = res.ANIM_ENEMY_DEAD;
+                        setAnimation(gs, res, objB, res.ANIM_ENEMY_DEAD);
+                        res.audio.play(AudioClip::ENEMY_DEATH, 1.0f, soundPan(gs, objB));
                     }
+                    // whatever it was up to, it starts over from DAMAGED (or DEAD).
+                    // stopped first, so the new coroutine reuses the old one's frame
+                    gs.behaviors.stop(index);
+                    gs.behaviors.start(index, enemyBehavior(state, gs, res, index));
                 } else {
                     passThrough = true;
                 }
@@ -919,11 +1440,16 @@ void collisionResponse(
             if (!passThrough) {
                 // if it hits something while moving, its velocity becomes 0
                 genericCollisionResponse(objA, objB, rectA, rectB, rectC);
+                gs.particles.emit(
+                    EMITTER_BULLET_IMPACT,
+                    rectC.x + rectC.w / 2,
+                    rectC.y + rectC.h / 2,
+                    objA.direction);
                 objA.velocity *= 0;
                 objA.data.bullet.state = BulletState::COLLIDING;
                 // ⚠️ this should be set whenever the state changes?
                 objA.texture = res.bulletHitTexture;
-                objA.currentAnimation = res.ANIM_BULLET_HIT;
+                setAnimation(gs, res, objA, res.ANIM_BULLET_HIT);
             }
             break;
         }
@@ -961,6 +1487,12 @@ void checkCollision(
 
     if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC)) {
         // found intersection, it means that they're colliding
+        Contact contact;
+        contact.objA = &objA;
+        contact.objB = &objB;
+        contact.intersection = rectC;
+        gs.contacts.push_back(contact);
+
         collisionResponse(state, gs, res, objA, objB, rectA, rectB, rectC, deltaTime);
     }
 };
@@ -970,12 +1502,13 @@ void handleShooting(
     GameState &gs,
     Resources &res,
     GameObject &obj,
-    Timer &weaponTimer,
-    SDL_Texture *texture,
-    SDL_Texture *shootingTexture,
+    TextureHandle texture,
+    TextureHandle shootingTexture,
     int animIndex,
     int shootAnimIndex) {
 
+    PlayerData &player = obj.data.player;
+
     if (!state.keys[SDL_SCANCODE_J]) {
         // if the key was released cancel the cast
         // ⚠️ actually i'd prefer that the cast was canceled on ESC? like fw or not
@@ -984,34 +1517,65 @@ void handleShooting(
         //
         // there's a current bug when sliding. and trying to shoot, i guess we need to
         // enforce that velocity is 0 before firing the weapon
-        weaponTimer.reset();
+        gs.timers.cancel(player.weaponTimer);
+        player.weaponReady = false;
         obj.texture = texture;
-        obj.currentAnimation = animIndex;
+        setAnimation(gs, res, obj, animIndex);
         return;
     }
 
     obj.texture = shootingTexture;
-    obj.currentAnimation = shootAnimIndex;
+    setAnimation(gs, res, obj, shootAnimIndex);
 
-    if (!weaponTimer.isTimeout()) {
+    if (!player.weaponReady) {
+        // start casting, onWeaponReady is called once the cast time is over
+        if (!gs.timers.isPending(player.weaponTimer)) {
+            player.weaponTimer =
+                gs.timers.schedule(WEAPON_CAST_TIME, onWeaponReady, &gs, gs.playerIndex);
+        }
         return;
     }
 
-    weaponTimer.reset();
+    // timed and counted on its own, apart from the rest of the update
+    ProfileScope profileScope(gs.profiler, AllocTag::SHOOTING);
+
+    player.weaponReady = false;
+
+    // reuse an inactive bullet when possible, otherwise grow the pool
+    GameObject *slot = NULL;
+    for (unsigned long i = 0; i < gs.bullets.size(); i++) {
+        if (gs.bullets[i].data.bullet.state == BulletState::INACTIVE) {
+            slot = &gs.bullets[i];
+            break;
+        }
+    }
+
+    if (!slot) {
+        gs.bullets.push_back(GameObject());
+        slot = &gs.bullets.back();
+        slot->animation = gs.animations.create();
+    }
+
+    // reset the slot to a fresh object, the playback slot stays with the bullet
+    int animation = slot->animation;
+    *slot = GameObject();
+    slot->animation = animation;
+
     // spawn some bullets
-    GameObject bullet;
+    GameObject &bullet = *slot;
     bullet.data.bullet = BulletData();
     bullet.data.bullet.state = BulletState::MOVING;
-    bullet.type = ObjectType::BULLET;
+    bullet.setType(ObjectType::BULLET);
     bullet.direction = obj.direction;
     bullet.texture = res.bulletTexture;
-    bullet.animations = res.bulletAnims;
-    bullet.currentAnimation = res.ANIM_BULLET_MOVING;
+    setAnimation(gs, res, bullet, res.ANIM_BULLET_MOVING);
     bullet.collider = SDL_FRect{
         0,
         0,
-        static_cast<float>(res.bulletTexture->h),
-        static_cast<float>(res.bulletTexture->h)};
+        static_cast<float>(res.textures.getHeight(res.bulletTexture)),
+        static_cast<float>(res.textures.getHeight(res.bulletTexture))};
+
+    res.audio.play(AudioClip::SHOOT, 0.6f, soundPan(gs, obj));
 
     bullet.maxSpeedX = 1000.0f;
     bullet.velocity = glm::vec2(obj.direction * (obj.velocity.x + 600.0f), 0);
@@ -1019,26 +1583,13 @@ void handleShooting(
     // good for random shooting objects, like spamming bullets out of a gun, for our staff
     // mage this is not really necessary so i set a low value of 10
     const float yVariation = 10;
-    const float yVaried = SDL_rand(yVariation) - yVariation / 2.0f;
+    const float yVaried = SDL_rand_r(&gs.rngState, yVariation) - yVariation / 2.0f;
 
     bullet.position = glm::vec2(
         // we need to offset the direction when going right because of
         // flip offset in the drawObject function
         obj.position.x + (obj.direction == 1 ? 48 : 0),
         obj.position.y + 16 + yVaried);
-
-    bool foundInactive = false;
-    for (unsigned long i = 0; i < gs.bullets.size(); i++) {
-        if (gs.bullets[i].data.bullet.state == BulletState::INACTIVE) {
-            foundInactive = true;
-            gs.bullets[i] = bullet;
-            break;
-        }
-    }
-
-    if (!foundInactive) {
-        gs.bullets.push_back(bullet);
-    }
 }
 
 void loadMap(
@@ -1073,8 +1624,8 @@ void loadMap(
                     ObjectType::ENEMY,
                     res.enemyIdleTexture);
                 obj.data.enemy.state = EnemyState::IDLE;
-                obj.animations = res.enemyAnims;
-                obj.currentAnimation = res.ANIM_ENEMY_IDLE;
+                obj.animation = gs.animations.create();
+                setAnimation(gs, res, obj, res.ANIM_ENEMY_IDLE);
                 obj.dynamic = true;
                 obj.collider = {50, 70, 20, 58};
                 obj.maxSpeedX = 50;
@@ -1089,8 +1640,8 @@ void loadMap(
                     createObject(state, row, col, ObjectType::PLAYER, res.idleTexture);
                 player.data.player = PlayerData();
                 player.data.player.state = PlayerState::IDLE;
-                player.animations = res.playerAnims;
-                player.currentAnimation = res.ANIM_PLAYER_IDLE;
+                player.animation = gs.animations.create();
+                setAnimation(gs, res, player, res.ANIM_PLAYER_IDLE);
                 // when pressing the "acelerador" do carro ele acelera 300
                 player.acceleration = glm::vec2(300, 0);
                 player.maxSpeedX = 150;
@@ -1172,6 +1723,15 @@ void createTiles(const SDLState &state, GameState &gs, Resources &res) {
     loadMap(state, gs, res, background);
     loadMap(state, gs, res, foreground);
 
+    // ground and panels are what enemies walk on and bump into
+    std::vector<bool> solid(MAP_ROWS * MAP_COLS);
+    for (int row = 0; row < MAP_ROWS; row++) {
+        for (int col = 0; col < MAP_COLS; col++) {
+            solid[row * MAP_COLS + col] = map[row][col] == 1 || map[row][col] == 2;
+        }
+    }
+    gs.nav.build(solid, MAP_ROWS, MAP_COLS);
+
     // after loading the map we always need to set the player in order for the game to run
     assert(gs.playerIndex != -1);
 }
@@ -1207,8 +1767,7 @@ void handleKeyInput(
     }
 }
 
-void drawParallaxBackground(
-    const SDLState &state,
+void scrollParallaxBackground(
     SDL_Texture *texture,
     float xVelocity,
     float &scrollPos,
@@ -1220,6 +1779,13 @@ void drawParallaxBackground(
     if (scrollPos <= -texture->w) {
         scrollPos = 0;
     }
+}
+
+void drawParallaxBackground(
+    const SDLState &state,
+    SDL_Texture *texture,
+    float scrollPos,
+    DrawStats &stats) {
 
     SDL_FRect dest = {scrollPos, 10, (float)state.logW, (float)state.logH};
 
@@ -1230,4 +1796,573 @@ void drawParallaxBackground(
     SDL_RenderTexture(state.renderer, texture, NULL, &dest);
     dest.x += -state.logW * 2;
     SDL_RenderTexture(state.renderer, texture, NULL, &dest);
+    for (int i = 0; i < 3; i++) {
+        stats.record(texture);
+    }
+}
+
+// the world, from the sky to the particles, plus the debug shapes when debugMode is on.
+// the text of the debug overlay isn't part of it.
+//
+// with `dirty`, frames where the camera didn't move only draw again the parts of the
+// screen that changed, see DirtyRegions. NULL always draws everything
+void drawScene(
+    const SDLState &state,
+    GameState &gs,
+    Resources &res,
+    float deltaTime,
+    DirtyRegions *dirty) {
+
+    // the parallax layers scroll with the player
+    float playerSpeed = gs.player().velocity.x;
+    scrollParallaxBackground(
+        res.textures.get(res.bg5Texture), playerSpeed, gs.bg5Scroll, 0.0375f, deltaTime);
+    scrollParallaxBackground(
+        res.textures.get(res.bg4Texture), playerSpeed, gs.bg4Scroll, 0.075f, deltaTime);
+    scrollParallaxBackground(
+        res.textures.get(res.bg3Texture), playerSpeed, gs.bg3Scroll, 0.150f, deltaTime);
+    scrollParallaxBackground(
+        res.textures.get(res.bg2Texture), playerSpeed, gs.bg2Scroll, 0.3f, deltaTime);
+
+    // draw background tiles before regular objects
+    for (GameObject &obj : gs.backgroundTiles) {
+        drawTile(gs, res, obj);
+    }
+
+    // draw all objects
+    for (std::vector<GameObject> &layer : gs.layers) {
+        for (GameObject &obj : layer) {
+            float srcSize = TILE_SIZE;
+            float destSize = TILE_SIZE;
+            if (obj.type == ObjectType::PLAYER) {
+                srcSize = 256;
+                destSize = 64;
+            } else if (obj.type == ObjectType::ENEMY) {
+                srcSize = 128;
+                destSize = 128;
+            }
+            drawObject(gs, res, obj, srcSize, destSize);
+        }
+    }
+
+    // draw bullets
+    for (GameObject &bullet : gs.bullets) {
+        assert(bullet.type == ObjectType::BULLET);
+
+        if (bullet.data.bullet.state == BulletState::INACTIVE) {
+            // dont render inactive bullets
+            continue;
+        }
+
+        drawObject(gs, res, bullet, bullet.collider.w, bullet.collider.h);
+    }
+
+    // draw foreground objects
+    for (GameObject &obj : gs.foregroundTiles) {
+        drawTile(gs, res, obj);
+    }
+
+    // the particle quads are the same in every region
+    gs.particles.build(gs.mapViewport.x);
+
+    // everything above was only queued, this is where it reaches the renderer
+    if (dirty) {
+        dirty->setCamera(gs.mapViewport.x);
+        if (playerSpeed != 0 || gs.debugMode) {
+            dirty->invalidate();
+        }
+        for (const DrawCommand &cmd : gs.drawList) {
+            if (cmd.dynamic) {
+                dirty->add(cmd.destRect);
+            }
+        }
+        if (gs.particles.getCount() > 0) {
+            dirty->add(gs.particles.getBounds(gs.mapViewport.x));
+        }
+    }
+    if (dirty && dirty->build()) {
+        for (const SDL_Rect &region : dirty->getRegions()) {
+            SDL_SetRenderClipRect(state.renderer, &region);
+            renderScene(state, gs, res, &region);
+        }
+        SDL_SetRenderClipRect(state.renderer, NULL);
+    } else {
+        renderScene(state, gs, res, NULL);
+    }
+    if (dirty) {
+        dirty->endFrame();
+    }
+
+    if (gs.debugMode) {
+        SDL_SetRenderDrawColor(state.renderer, 255, 0, 0, 122);
+        for (const SDL_FRect &rect : gs.debugRects) {
+            SDL_RenderRect(state.renderer, &rect);
+        }
+
+        // the tiles enemies can stand on, the one they're chasing in white
+        for (int i = 0; i < gs.nav.getNodeCount(); i++) {
+            const NavNode &node = gs.nav.getNode(i);
+            float groundY = static_cast<float>(
+                state.logH - (MAP_ROWS - node.row - 1) * TILE_SIZE);
+            SDL_FRect rect = {
+                node.col * TILE_SIZE + 12 - gs.mapViewport.x, groundY - 8, 8, 8};
+            if (i == gs.navTarget) {
+                SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
+            } else {
+                SDL_SetRenderDrawColor(state.renderer, 0, 255, 0, 255);
+            }
+            SDL_RenderFillRect(state.renderer, &rect);
+        }
+
+        // where things are touching this frame
+        SDL_SetRenderDrawColor(state.renderer, 255, 255, 0, 255);
+        for (const Contact &contact : gs.contacts) {
+            SDL_FRect rect = contact.intersection;
+            rect.x -= gs.mapViewport.x;
+            SDL_RenderRect(state.renderer, &rect);
+        }
+    }
+}
+
+// draws what drawScene() queued, `region` is the clip rect set on the renderer or NULL
+// for the whole screen
+void renderScene(
+    const SDLState &state,
+    GameState &gs,
+    Resources &res,
+    const SDL_Rect *region) {
+
+    SDL_SetRenderDrawColor(state.renderer, 20, 0, 0, 255);
+    if (region) {
+        // 💡 clearing ignores the clip rect, it would wipe the whole screen
+        SDL_FRect rect = {
+            static_cast<float>(region->x),
+            static_cast<float>(region->y),
+            static_cast<float>(region->w),
+            static_cast<float>(region->h)};
+        SDL_RenderFillRect(state.renderer, &rect);
+    } else {
+        SDL_RenderClear(state.renderer);
+    }
+
+    // draw background images
+    SDL_Texture *sky = res.textures.get(res.bg1Texture);
+    SDL_RenderTexture(state.renderer, sky, NULL, NULL);
+    gs.drawStats.record(sky);
+    drawParallaxBackground(
+        state, res.textures.get(res.bg5Texture), gs.bg5Scroll, gs.drawStats);
+    drawParallaxBackground(
+        state, res.textures.get(res.bg4Texture), gs.bg4Scroll, gs.drawStats);
+    drawParallaxBackground(
+        state, res.textures.get(res.bg3Texture), gs.bg3Scroll, gs.drawStats);
+    drawParallaxBackground(
+        state, res.textures.get(res.bg2Texture), gs.bg2Scroll, gs.drawStats);
+
+    flushDrawList(state.renderer, gs.drawList, gs.drawStats);
+    gs.particles.submit(state.renderer);
+    if (gs.particles.getCount() > 0) {
+        gs.drawStats.record(NULL);
+    }
+}
+
+// keeps J held so the player shoots whenever idle, and walks right and left in between
+void scriptAllocTestInput(bool keys[], uint64_t frame) {
+    int phase = (frame / 60) % 4;
+    keys[SDL_SCANCODE_J] = true;
+    keys[SDL_SCANCODE_D] = phase == 0;
+    keys[SDL_SCANCODE_A] = phase == 2;
+}
+
+// switches the clip an object is playing, the clip only restarts when it's a different
+// one, so this is safe to call every frame
+void setAnimation(GameState &gs, Resources &res, GameObject &obj, int anim) {
+    if (obj.currentAnimation == anim) {
+        return;
+    }
+    obj.currentAnimation = anim;
+    gs.animations.play(obj.animation, res.animations[anim]);
+}
+
+// stops animating and shows a fixed sprite (1-based) of the last played sprite sheet
+void stopAnimation(GameState &gs, GameObject &obj, int spriteFrame) {
+    obj.currentAnimation = -1;
+    obj.spriteFrame = spriteFrame;
+    gs.animations.stop(obj.animation, spriteFrame - 1);
+}
+
+// timers refer to objects by their index in the characters layer, which never changes
+// after the map is loaded
+int characterIndex(GameState &gs, GameObject &obj) {
+    return static_cast<int>(&obj - &gs.layers[LAYER_IDX_CHARACTERS][0]);
+}
+
+// timer callbacks, `context` is always the GameState and `index` from characterIndex()
+void onWeaponReady(void *context, int index) {
+    GameState &gs = *static_cast<GameState *>(context);
+    gs.layers[LAYER_IDX_CHARACTERS][index].data.player.weaponReady = true;
+}
+
+void onFlashOver(void *context, int index) {
+    GameState &gs = *static_cast<GameState *>(context);
+    gs.layers[LAYER_IDX_CHARACTERS][index].shouldFlash = false;
+}
+
+// sounds on the left of the screen play on the left speaker and so on
+float soundPan(const GameState &gs, const GameObject &obj) {
+    float halfWidth = gs.mapViewport.w / 2;
+    return (obj.position.x - gs.mapViewport.x - halfWidth) / halfWidth;
+}
+
+// the nav graph node under the object's feet, or the one it's going to land on when in
+// the air. -1 when there's none (above a pit)
+int navNodeAt(const SDLState &state, GameState &gs, const GameObject &obj) {
+    const float mapTop = static_cast<float>(state.logH - MAP_ROWS * TILE_SIZE);
+    float feetX = obj.position.x + obj.collider.x + obj.collider.w / 2;
+    // one pixel up, so it's the tile we stand in and not the ground below it
+    float feetY = obj.position.y + obj.collider.y + obj.collider.h - 1;
+    int col = static_cast<int>(std::floor(feetX / TILE_SIZE));
+    int row = static_cast<int>(std::floor((feetY - mapTop) / TILE_SIZE));
+    return gs.nav.findNode(row, col);
+}
+
+// which way a grounded enemy should walk to reach the player. when the way there is a
+// jump, the jump starts here
+float steerEnemy(const SDLState &state, GameState &gs, GameObject &obj) {
+    const GameObject &player = gs.player();
+    float feetX = obj.position.x + obj.collider.x + obj.collider.w / 2;
+    float playerX = player.position.x + player.collider.x + player.collider.w / 2;
+
+    int from = navNodeAt(state, gs, obj);
+    if (from == -1 || gs.navTarget == -1) {
+        // somewhere the graph doesn't know about, straight at the player then
+        return playerX < feetX ? -1 : 1;
+    }
+
+    const NavLink *link = gs.nav.nextLink(from, gs.navTarget);
+    if (!link) {
+        if (from == gs.navTarget && std::abs(playerX - feetX) > 4) {
+            return playerX < feetX ? -1 : 1;
+        }
+        // already there, or there's no way to the player. waiting is better than
+        // walking off a ledge
+        obj.velocity.x = 0;
+        return 0;
+    }
+
+    const NavNode &fromNode = gs.nav.getNode(from);
+    const NavNode &toNode = gs.nav.getNode(link->to);
+    float toX = (toNode.col + 0.5f) * TILE_SIZE;
+
+    if (link->type == NavLinkType::JUMP) {
+        // up to one tile above the highest end, the same arc the graph checked for
+        // walls. then how long it's in the air tells how fast to go across
+        float rise = static_cast<float>((fromNode.row - toNode.row) * TILE_SIZE);
+        float peak = std::max(rise, 0.0f) + TILE_SIZE;
+        float jumpSpeed = std::sqrt(2 * GRAVITY * peak);
+        float airTime = jumpSpeed / GRAVITY + std::sqrt(2 * (peak - rise) / GRAVITY);
+        obj.velocity = glm::vec2((toX - feetX) / airTime, -jumpSpeed);
+        obj.data.enemy.state = EnemyState::JUMPING;
+    }
+
+    // walks and drops just need walking towards the next tile
+    return toX < feetX ? -1 : 1;
+}
+
+// conditions enemyBehavior() waits on, `context` is the GameState and `index` the enemy
+bool isPlayerWithin(void *context, int index, float distance) {
+    GameState &gs = *static_cast<GameState *>(context);
+    const GameObject &obj = gs.layers[LAYER_IDX_CHARACTERS][index];
+    return glm::length(gs.player().position - obj.position) < distance;
+}
+
+bool hasLanded(void *context, int index, float) {
+    GameState &gs = *static_cast<GameState *>(context);
+    return gs.layers[LAYER_IDX_CHARACTERS][index].data.enemy.state != EnemyState::JUMPING;
+}
+
+bool isAnimationDone(void *context, int index, float) {
+    GameState &gs = *static_cast<GameState *>(context);
+    return gs.animations.isDone(gs.layers[LAYER_IDX_CHARACTERS][index].animation);
+}
+
+// the enemy AI, a coroutine that runs until the enemy dies (see behavior.h). it's
+// started over from obj.data.enemy.state when a bullet hits and after restoring a
+// snapshot, so every state sets up everything it needs first, and waits that take time
+// go through data.wakeTimer, which is in the snapshots
+Behavior enemyBehavior(const SDLState &state, GameState &gs, Resources &res, int index) {
+    GameObject &obj = gs.layers[LAYER_IDX_CHARACTERS][index];
+    EnemyData &data = obj.data.enemy;
+    BehaviorScheduler &ai = gs.behaviors;
+
+    for (;;) {
+        switch (data.state) {
+        case EnemyState::IDLE: {
+            setAnimation(gs, res, obj, res.ANIM_ENEMY_IDLE);
+            obj.texture = res.enemyIdleTexture;
+            data.steering = 0;
+            obj.acceleration = glm::vec2(0);
+            obj.velocity.x = 0;
+            // 💡 gets "aggroed" by the player whenever the player is close enough
+            co_await ai.until(index, isPlayerWithin, &gs, 200);
+            data.state = EnemyState::WALKING;
+            break;
+        }
+        case EnemyState::WALKING: {
+            setAnimation(gs, res, obj, res.ANIM_ENEMY_WALK);
+            obj.texture = res.enemyWalkTexture;
+            obj.acceleration = glm::vec2(100, 0);
+            // chasing is the only thing that needs every frame
+            while (data.state == EnemyState::WALKING && isPlayerWithin(&gs, index, 400)) {
+                // the nav graph picks the way, while falling off a ledge we just keep
+                // going the same way
+                data.steering = obj.grounded ? steerEnemy(state, gs, obj) : obj.direction;
+                co_await ai.nextFrame(index);
+            }
+            if (data.state == EnemyState::WALKING) {
+                data.state = EnemyState::IDLE;
+            }
+            break;
+        }
+        case EnemyState::JUMPING: {
+            // update() sets it back to WALKING when it lands
+            obj.acceleration = glm::vec2(0);
+            co_await ai.until(index, hasLanded, &gs, 0);
+            break;
+        }
+        case EnemyState::DAMAGED: {
+            // stays still for a while
+            data.steering = 0;
+            obj.acceleration = glm::vec2(0);
+            obj.velocity.x = 0;
+            co_await ai.sleep(index, data.wakeTimer, ENEMY_DAMAGED_TIME);
+            data.state = EnemyState::IDLE;
+            break;
+        }
+        case EnemyState::DEAD: {
+            data.steering = 0;
+            obj.acceleration = glm::vec2(0);
+            obj.velocity.x = 0;
+            if (obj.currentAnimation != -1) {
+                co_await ai.until(index, isAnimationDone, &gs, 0);
+                // 💡 to stop an animation set to -1
+                //  remove animation and set to the last sprite of the spritesheet
+                stopAnimation(gs, obj, 4);
+            }
+            co_return;
+        }
+        }
+    }
+}
+
+// gives every enemy its behavior, from scratch, after loading the map and after
+// restoring a snapshot
+void startEnemyBehaviors(const SDLState &state, GameState &gs, Resources &res) {
+    std::vector<GameObject> &characters = gs.layers[LAYER_IDX_CHARACTERS];
+    gs.behaviors.init(static_cast<int>(characters.size()), gs.timers);
+    for (size_t i = 0; i < characters.size(); i++) {
+        if (characters[i].type == ObjectType::ENEMY) {
+            const int index = static_cast<int>(i);
+            gs.behaviors.start(index, enemyBehavior(state, gs, res, index));
+        }
+    }
+}
+
+// one step of the game. live frames read the keyboard, replayed frames (see
+// SnapshotHistory) pass `replayKeys` and get their keys from the recorded input instead
+void simulate(
+    SDLState &state,
+    GameState &gs,
+    Resources &res,
+    const FrameInput &input,
+    bool replayKeys[]) {
+    const float deltaTime = input.deltaTime;
+    const bool *liveKeys = state.keys;
+    if (replayKeys) {
+        replayKeys[SDL_SCANCODE_A] = input.left;
+        replayKeys[SDL_SCANCODE_D] = input.right;
+        replayKeys[SDL_SCANCODE_J] = input.shoot;
+        state.keys = replayKeys;
+    }
+    if (input.jump) {
+        handleKeyInput(state, gs, gs.player(), SDL_SCANCODE_SPACE, true);
+    }
+
+    // timers fire and all animations step together, before any object looks at them
+    gs.timers.advance(deltaTime);
+    gs.animations.update(deltaTime);
+
+    // every enemy chases the same target, so they share the cached path to it
+    int playerNode = navNodeAt(state, gs, gs.player());
+    if (playerNode != -1) {
+        gs.navTarget = playerNode;
+    }
+
+    // the enemies that have something to do this frame decide what to do, the others
+    // are waiting on a timer or a condition and aren't even looked at
+    gs.behaviors.run();
+
+    // only the characters move. the level layer is all static tiles (see
+    // GameObject::staticBody), hundreds of them, so it isn't even walked
+    for (GameObject &obj : gs.layers[LAYER_IDX_CHARACTERS]) {
+        assert(!obj.staticBody);
+        update(state, gs, res, obj, deltaTime);
+    }
+
+    // update bullets
+
+    for (GameObject &obj : gs.bullets) {
+        assert(obj.type == ObjectType::BULLET);
+        update(state, gs, res, obj, deltaTime);
+    }
+
+    // calculate viewport / camera position
+    gs.mapViewport.x = (gs.player().position.x + static_cast<float>(TILE_SIZE) / 2) -
+                       gs.mapViewport.w / 2;
+
+    state.keys = liveKeys;
+}
+
+// FNV-1a, see simulationHash()
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// a fingerprint of the state of the characters and bullets, used to check replays end up
+// where they should. comparing whole snapshots doesn't work, the padding bytes inside of
+// the objects can be anything
+uint64_t simulationHash(GameState &gs) {
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashBytes(hash, &gs.rngState, sizeof(gs.rngState));
+    const std::vector<GameObject> *lists[] = {
+        &gs.layers[LAYER_IDX_CHARACTERS], &gs.bullets};
+    for (int l = 0; l < 2; l++) {
+        for (const GameObject &obj : *lists[l]) {
+            hash = hashBytes(hash, &obj.position, sizeof(obj.position));
+            hash = hashBytes(hash, &obj.velocity, sizeof(obj.velocity));
+            hash = hashBytes(hash, &obj.direction, sizeof(obj.direction));
+            hash = hashBytes(hash, &obj.currentAnimation, sizeof(obj.currentAnimation));
+            hash = hashBytes(hash, &obj.data.player.state, sizeof(PlayerState));
+            hash = hashBytes(hash, &obj.data.enemy.state, sizeof(EnemyState));
+            hash = hashBytes(hash, &obj.data.enemy.health, sizeof(int));
+            hash = hashBytes(hash, &obj.data.bullet.state, sizeof(BulletState));
+            if (obj.animation != -1) {
+                int frame = gs.animations.getFrame(obj.animation);
+                hash = hashBytes(hash, &frame, sizeof(frame));
+            }
+        }
+    }
+    int pending = gs.timers.getPendingCount();
+    return hashBytes(hash, &pending, sizeof(pending));
+}
+
+// --bench: draws the level offscreen with the camera going from one end of the level to
+// the other and back, the same frames every run, and prints what the draw pass costs.
+// nothing is simulated, only the camera and the animations move
+int runBenchmark(const GameOptions &options) {
+    SDLState state;
+    SDL_Surface *target = NULL;
+    if (!initializeOffscreen(state, target)) {
+        return 1;
+    }
+
+    Resources res;
+    res.load(state, options);
+    res.audio.setMuted(true);
+    GameState gs(state);
+    createTiles(state, gs, res);
+
+    const float deltaTime = 1.0f / 60;
+    const int frames = options.benchFrames;
+    const float travel = static_cast<float>(MAP_COLS * TILE_SIZE) - gs.mapViewport.w;
+    // the parallax layers scroll with the player's speed
+    const float speed = travel * 2 / (frames * deltaTime);
+
+    std::vector<double> renderMs;
+    renderMs.reserve(frames);
+    uint64_t drawCalls = 0, textureSwitches = 0;
+
+    // frame -1 loads the textures and isn't measured
+    for (int frame = -1; frame < frames; frame++) {
+        gs.beginFrame();
+        res.textures.beginFrame();
+
+        float t = frame < 0 ? 0 : static_cast<float>(frame) / frames;
+        bool goingRight = t < 0.5f;
+        gs.mapViewport.x = (goingRight ? t * 2 : 2 - t * 2) * travel;
+        GameObject &player = gs.player();
+        player.position.x =
+            gs.mapViewport.x + gs.mapViewport.w / 2 - static_cast<float>(TILE_SIZE) / 2;
+        player.velocity.x = goingRight ? speed : -speed;
+        player.direction = goingRight ? 1 : -1;
+        gs.animations.update(deltaTime);
+
+        uint64_t start = SDL_GetTicksNS();
+        drawScene(state, gs, res, deltaTime, NULL);
+        // the software renderer queues the draws too, this is where the pixels get done
+        SDL_FlushRenderer(state.renderer);
+        uint64_t elapsed = SDL_GetTicksNS() - start;
+
+        if (frame >= 0) {
+            renderMs.push_back(elapsed / 1e6);
+            drawCalls += gs.drawStats.drawCalls;
+            textureSwitches += gs.drawStats.textureSwitches;
+        }
+    }
+
+    double total = 0;
+    for (size_t i = 0; i < renderMs.size(); i++) {
+        total += renderMs[i];
+    }
+    std::sort(renderMs.begin(), renderMs.end());
+    std::cout << "Bench (" << SDL_GetRendererName(state.renderer) << ", " << state.logW
+              << "x" << state.logH << ", " << frames << " frames): render mean "
+              << total / frames << "ms, p50 " << renderMs[frames / 2] << "ms, p95 "
+              << renderMs[frames * 95 / 100] << "ms, max " << renderMs.back()
+              << "ms" << std::endl;
+    std::cout << "Per frame: " << static_cast<double>(drawCalls) / frames
+              << " draw calls, " << static_cast<double>(textureSwitches) / frames
+              << " texture switches" << std::endl;
+    res.textures.printReport(std::cout);
+
+    res.unload();
+    cleanup(state);
+    SDL_DestroySurface(target);
+    return 0;
+}
+
+// one line about what the game was doing, for the hitch log
+const char *describeState(GameState &gs) {
+    int enemies = 0;
+    for (const GameObject &obj : gs.layers[LAYER_IDX_CHARACTERS]) {
+        if (obj.type == ObjectType::ENEMY && obj.data.enemy.state != EnemyState::DEAD) {
+            enemies++;
+        }
+    }
+    int activeBullets = 0;
+    for (const GameObject &bullet : gs.bullets) {
+        if (bullet.data.bullet.state != BulletState::INACTIVE) {
+            activeBullets++;
+        }
+    }
+    const GameObject &player = gs.player();
+    return formatText(
+        gs.frameArena,
+        "level %zu, characters %zu (%d enemies alive), bullets %d/%zu (pool %d), "
+        "player state %d at %.0f,%.0f grounded %d, particles %d, timers %d",
+        gs.layers[LAYER_IDX_LEVEL].size(),
+        gs.layers[LAYER_IDX_CHARACTERS].size(),
+        enemies,
+        activeBullets,
+        gs.bullets.size(),
+        BULLET_POOL_SIZE,
+        static_cast<int>(player.data.player.state),
+        player.position.x,
+        player.position.y,
+        player.grounded,
+        gs.particles.getCount(),
+        gs.timers.getPendingCount());
 }
@@ -0,0 +1,334 @@
+#ifndef navgraph_h
+#define navgraph_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+// how far enemies can jump, in tiles
+const int NAV_JUMP_UP = 3;
+const int NAV_JUMP_DOWN = 3;
+const int NAV_JUMP_ACROSS = 4;
+// characters are 2 tiles tall, the tile above where they stand has to be empty too
+const int NAV_BODY_HEIGHT = 2;
+// targets whose paths are kept around, see NavGraph::nextLink()
+const int NAV_CACHE_SIZE = 8;
+
+enum class NavLinkType { WALK, DROP, JUMP };
+
+// a way to get from one node to another
+struct NavLink {
+    NavLinkType type;
+    int to;
+    float cost;
+};
+
+// a tile something can stand on: empty, room above for the body and solid below
+struct NavNode {
+    int row, col;
+    // the node's links are links[firstLink] to links[firstLink + linkCount - 1]
+    int firstLink, linkCount;
+};
+
+// where the enemies can walk in the level and how they get from one place to another.
+//
+// built once from the tile grid when the map loads: every tile you can stand on becomes
+// a node, linked to its neighbours by walking, by dropping off a ledge or by jumping up
+// or across a gap. asking for the way to a target runs a search backwards from the target
+// over the whole graph, which gives the next link to take from EVERY node at once. that
+// result is cached per target, so all the enemies chasing the player share one search
+// and it only runs again when the player reaches another tile.
+//
+// 💡 nothing allocates after build(), searches reuse the memory of the cache entries
+class NavGraph {
+    struct PathCache {
+        // target node, -1 when the entry is unused
+        int target;
+        uint64_t lastUsed;
+        // link to take from each node, -1 when there's no way to the target
+        std::vector<int> nextLink;
+        std::vector<float> cost;
+    };
+
+    // what the search keeps in its heap, sorted by cost
+    struct Frontier {
+        float cost;
+        int node;
+        bool operator>(const Frontier &other) const { return cost > other.cost; }
+    };
+
+    int rows, cols;
+    std::vector<bool> solid;
+    // node of each tile, -1 when you can't stand there
+    std::vector<int> nodeIndex;
+    std::vector<NavNode> nodes;
+    std::vector<NavLink> links;
+    // the links coming into each node, as indices into `links`, for searching backwards
+    std::vector<int> firstIncoming;
+    std::vector<int> incoming;
+    std::vector<int> linkFrom;
+
+    PathCache cache[NAV_CACHE_SIZE];
+    std::vector<Frontier> heap;
+    uint64_t queries;
+    uint64_t searches;
+
+  public:
+    NavGraph() : rows(0), cols(0), queries(0), searches(0) {}
+
+    // `solidTiles` is rows * cols, row by row, true where the tile blocks movement
+    void build(const std::vector<bool> &solidTiles, int rowCount, int colCount) {
+        rows = rowCount;
+        cols = colCount;
+        solid = solidTiles;
+
+        nodes.clear();
+        links.clear();
+        nodeIndex.assign(rows * cols, -1);
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                if (canStand(row, col)) {
+                    NavNode node;
+                    node.row = row;
+                    node.col = col;
+                    node.firstLink = node.linkCount = 0;
+                    nodeIndex[row * cols + col] = static_cast<int>(nodes.size());
+                    nodes.push_back(node);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < nodes.size(); i++) {
+            NavNode &node = nodes[i];
+            node.firstLink = static_cast<int>(links.size());
+            addWalkAndDropLinks(node);
+            addJumpLinks(node);
+            node.linkCount = static_cast<int>(links.size()) - node.firstLink;
+        }
+
+        buildIncoming();
+
+        for (int i = 0; i < NAV_CACHE_SIZE; i++) {
+            cache[i].target = -1;
+            cache[i].lastUsed = 0;
+            cache[i].nextLink.assign(nodes.size(), -1);
+            cache[i].cost.assign(nodes.size(), 0);
+        }
+        heap.reserve(links.size() + nodes.size());
+    }
+
+    // the node at the tile, or the first one below it. -1 when there's only a pit under
+    // it, or the tile is outside of the map
+    int findNode(int row, int col) const {
+        if (col < 0 || col >= cols) {
+            return -1;
+        }
+        for (int r = std::max(row, 0); r < rows; r++) {
+            if (nodeIndex[r * cols + col] != -1) {
+                return nodeIndex[r * cols + col];
+            }
+            if (isSolid(r, col)) {
+                return -1;
+            }
+        }
+        return -1;
+    }
+
+    // the link to take from `from` to get closer to `target`. NULL when already there or
+    // when the target can't be reached from `from`
+    const NavLink *nextLink(int from, int target) {
+        queries++;
+        if (from == target) {
+            return NULL;
+        }
+        const PathCache &paths = pathsTo(target);
+        int link = paths.nextLink[from];
+        return link == -1 ? NULL : &links[link];
+    }
+
+    const NavNode &getNode(int index) const { return nodes[index]; }
+    int getNodeCount() const { return static_cast<int>(nodes.size()); }
+    int getLinkCount() const { return static_cast<int>(links.size()); }
+    uint64_t getQueries() const { return queries; }
+    // queries that weren't answered by the cache
+    uint64_t getSearches() const { return searches; }
+
+  private:
+    // everything outside of the map is empty, so you can jump above it but not stand
+    // below it
+    bool isSolid(int row, int col) const {
+        if (row < 0 || col < 0 || row >= rows || col >= cols) {
+            return false;
+        }
+        return solid[row * cols + col];
+    }
+
+    bool canStand(int row, int col) const {
+        if (isSolid(row, col) || !isSolid(row + 1, col)) {
+            return false;
+        }
+        for (int i = 1; i < NAV_BODY_HEIGHT; i++) {
+            if (isSolid(row - i, col)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void addLink(NavLinkType type, int to, float cost) {
+        NavLink link;
+        link.type = type;
+        link.to = to;
+        link.cost = cost;
+        links.push_back(link);
+    }
+
+    void addWalkAndDropLinks(const NavNode &node) {
+        for (int side = -1; side <= 1; side += 2) {
+            int col = node.col + side;
+            if (col < 0 || col >= cols || !clearColumn(col, node.row, node.row)) {
+                continue;
+            }
+            int neighbour = nodeIndex[node.row * cols + col];
+            if (neighbour != -1) {
+                addLink(NavLinkType::WALK, neighbour, 1);
+                continue;
+            }
+            // walking off the ledge, falls until it lands. nothing below means a pit and
+            // no link at all, so enemies never walk into one
+            int landing = findNode(node.row, col);
+            if (landing != -1) {
+                int fall = nodes[landing].row - node.row;
+                addLink(NavLinkType::DROP, landing, 1 + fall * 0.5f);
+            }
+        }
+    }
+
+    // the jump goes straight up to one tile above the highest of both ends, across, and
+    // straight down. a real jump is an arc that fits inside of that, so when that path is
+    // clear the jump is too
+    void addJumpLinks(const NavNode &node) {
+        for (int row = node.row - NAV_JUMP_UP; row <= node.row + NAV_JUMP_DOWN; row++) {
+            for (int col = node.col - NAV_JUMP_ACROSS; col <= node.col + NAV_JUMP_ACROSS;
+                 col++) {
+                if (row < 0 || row >= rows || col < 0 || col >= cols ||
+                    col == node.col) {
+                    continue;
+                }
+                int to = nodeIndex[row * cols + col];
+                // next door on the same row is just a walk
+                if (to == -1 || (row == node.row && std::abs(col - node.col) == 1)) {
+                    continue;
+                }
+
+                int peak = std::min(row, node.row) - 1;
+                if (!clearColumn(node.col, peak, node.row) ||
+                    !clearRow(peak, node.col, col) || !clearColumn(col, peak, row)) {
+                    continue;
+                }
+
+                float cost = 2 + std::abs(col - node.col) + std::abs(row - node.row);
+                addLink(NavLinkType::JUMP, to, cost);
+            }
+        }
+    }
+
+    // room for the body anywhere from `top` to `bottom` (the rows where the feet go)
+    bool clearColumn(int col, int top, int bottom) const {
+        for (int row = top - NAV_BODY_HEIGHT + 1; row <= bottom; row++) {
+            if (isSolid(row, col)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool clearRow(int row, int fromCol, int toCol) const {
+        int step = fromCol < toCol ? 1 : -1;
+        for (int col = fromCol; col != toCol + step; col += step) {
+            if (!clearColumn(col, row, row)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void buildIncoming() {
+        linkFrom.assign(links.size(), 0);
+        firstIncoming.assign(nodes.size() + 1, 0);
+        for (size_t i = 0; i < nodes.size(); i++) {
+            for (int l = 0; l < nodes[i].linkCount; l++) {
+                linkFrom[nodes[i].firstLink + l] = static_cast<int>(i);
+                firstIncoming[links[nodes[i].firstLink + l].to + 1]++;
+            }
+        }
+        for (size_t i = 0; i < nodes.size(); i++) {
+            firstIncoming[i + 1] += firstIncoming[i];
+        }
+        incoming.assign(links.size(), 0);
+        std::vector<int> filled(firstIncoming.begin(), firstIncoming.end() - 1);
+        for (size_t l = 0; l < links.size(); l++) {
+            incoming[filled[links[l].to]++] = static_cast<int>(l);
+        }
+    }
+
+    // the cached search for `target`, running it over the least recently used entry when
+    // it isn't cached
+    const PathCache &pathsTo(int target) {
+        PathCache *oldest = &cache[0];
+        for (int i = 0; i < NAV_CACHE_SIZE; i++) {
+            if (cache[i].target == target) {
+                cache[i].lastUsed = queries;
+                return cache[i];
+            }
+            if (cache[i].lastUsed < oldest->lastUsed) {
+                oldest = &cache[i];
+            }
+        }
+        search(*oldest, target);
+        oldest->lastUsed = queries;
+        return *oldest;
+    }
+
+    // dijkstra from the target following the links backwards, so each node ends up with
+    // the cost to reach the target and the first link of the way there
+    void search(PathCache &paths, int target) {
+        searches++;
+        paths.target = target;
+        std::fill(paths.nextLink.begin(), paths.nextLink.end(), -1);
+        std::fill(paths.cost.begin(), paths.cost.end(), -1.0f);
+
+        paths.cost[target] = 0;
+        heap.clear();
+        Frontier start = {0, target};
+        heap.push_back(start);
+
+        std::greater<Frontier> order;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), order);
+            Frontier current = heap.back();
+            heap.pop_back();
+            if (current.cost > paths.cost[current.node]) {
+                continue; // already reached through a cheaper way
+            }
+
+            for (int i = firstIncoming[current.node]; i < firstIncoming[current.node + 1];
+                 i++) {
+                int link = incoming[i];
+                int from = linkFrom[link];
+                float cost = current.cost + links[link].cost;
+                if (paths.cost[from] < 0 || cost < paths.cost[from]) {
+                    paths.cost[from] = cost;
+                    paths.nextLink[from] = link;
+                    Frontier next = {cost, from};
+                    heap.push_back(next);
+                    std::push_heap(heap.begin(), heap.end(), order);
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef particles_h
+#define particles_h
+
+#include "SDL3/SDL_render.h"
+#include "SDL3/SDL_timer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// particles alive at once, emitting more than this just drops the extra ones
+const int MAX_PARTICLES = 1 << 17;
+
+// what an emitter throws out, see ParticleSystem::emit()
+struct ParticleEmitter {
+    int count;
+    // radians, 0 goes right and PI / 2 goes down. particles go anywhere inside
+    // angle +/- spread
+    float angle, spread;
+    float minSpeed, maxSpeed;
+    // seconds
+    float minLife, maxLife;
+    // pixels, particles are squares
+    float size;
+    float gravity;
+    // particles fade out from this color as they get older
+    SDL_FColor color;
+};
+
+// sparks flying back from where the bullet hit
+const ParticleEmitter EMITTER_BULLET_IMPACT = {
+    24, 3.14159f, 1.2f, 60, 220, 0.2f, 0.45f, 2, 600, {1.0f, 0.7f, 0.2f, 1.0f}};
+// bones everywhere
+const ParticleEmitter EMITTER_ENEMY_DEATH = {
+    120, -1.5708f, 3.14159f, 40, 260, 0.5f, 1.2f, 3, 400, {0.9f, 0.85f, 0.75f, 1.0f}};
+// a puff of dust under the feet
+const ParticleEmitter EMITTER_LANDING = {
+    16, -1.5708f, 1.4f, 20, 80, 0.25f, 0.5f, 2, 150, {0.7f, 0.6f, 0.45f, 0.8f}};
+
+// cosmetic particles: sparks, dust, debris.
+//
+// every field of the particles has its own array (structure of arrays) instead of an
+// array of Particle structs. update() goes over the arrays with simple loops without
+// branches, which the compiler turns into SIMD instructions that move 4 or 8 particles at
+// a time, and each loop only pulls the fields it uses through the cache. everything is
+// allocated once, up front, so emitting never allocates.
+//
+// drawing is one SDL_RenderGeometry call with a quad per particle, instead of a draw call
+// per particle. the quads are built once per frame by build(), submit() can then draw
+// them as many times as needed (once per dirty region)
+class ParticleSystem {
+    std::vector<float> posX, posY, velX, velY;
+    std::vector<float> age, life, gravity, size;
+    std::vector<float> red, green, blue, alpha;
+    int count;
+    bool enabled;
+
+    // 4 corners per particle, the indices make 2 triangles out of each 4 corners and
+    // never change
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    // particles don't need a good random generator, but they shouldn't touch the game's
+    uint32_t seed;
+
+    uint64_t updateNs, drawNs;
+
+  public:
+    ParticleSystem()
+        : count(0), enabled(true), seed(2463534242u), updateNs(0), drawNs(0) {
+        std::vector<float> *fields[] = {
+            &posX, &posY, &velX, &velY, &age, &life,
+            &gravity, &size, &red, &green, &blue, &alpha};
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            fields[i]->resize(MAX_PARTICLES);
+        }
+
+        vertices.resize(MAX_PARTICLES * 4);
+        indices.resize(MAX_PARTICLES * 6);
+        for (int i = 0; i < MAX_PARTICLES; i++) {
+            int corner = i * 4;
+            int *quad = &indices[i * 6];
+            quad[0] = corner;
+            quad[1] = corner + 1;
+            quad[2] = corner + 2;
+            quad[3] = corner + 2;
+            quad[4] = corner + 3;
+            quad[5] = corner;
+        }
+    }
+
+    // `direction` -1 mirrors the emitter horizontally, see GameObject::direction
+    void emit(const ParticleEmitter &emitter, float x, float y, float direction) {
+        if (!enabled) {
+            return;
+        }
+        float baseAngle = direction < 0 ? 3.14159f - emitter.angle : emitter.angle;
+        for (int n = 0; n < emitter.count && count < MAX_PARTICLES; n++) {
+            int i = count++;
+            float angle = baseAngle + (randomUnit() * 2 - 1) * emitter.spread;
+            float speed =
+                emitter.minSpeed + randomUnit() * (emitter.maxSpeed - emitter.minSpeed);
+            posX[i] = x;
+            posY[i] = y;
+            velX[i] = std::cos(angle) * speed;
+            velY[i] = std::sin(angle) * speed;
+            age[i] = 0;
+            life[i] =
+                emitter.minLife + randomUnit() * (emitter.maxLife - emitter.minLife);
+            gravity[i] = emitter.gravity;
+            size[i] = emitter.size;
+            red[i] = emitter.color.r;
+            green[i] = emitter.color.g;
+            blue[i] = emitter.color.b;
+            alpha[i] = emitter.color.a;
+        }
+    }
+
+    void update(float deltaTime) {
+        uint64_t start = SDL_GetTicksNS();
+        const int n = count;
+
+        // 💡 one loop per step, with plain pointers, so every loop is trivially
+        // vectorizable
+        float *px = &posX[0], *py = &posY[0], *vx = &velX[0], *vy = &velY[0];
+        float *ages = &age[0];
+        const float *g = &gravity[0];
+        for (int i = 0; i < n; i++) {
+            vy[i] += g[i] * deltaTime;
+        }
+        for (int i = 0; i < n; i++) {
+            px[i] += vx[i] * deltaTime;
+            py[i] += vy[i] * deltaTime;
+        }
+        for (int i = 0; i < n; i++) {
+            ages[i] += deltaTime;
+        }
+
+        // dead particles are replaced by the last one, so the live ones stay packed at
+        // the front of the arrays
+        for (int i = 0; i < count;) {
+            if (age[i] >= life[i]) {
+                move(count - 1, i);
+                count--;
+            } else {
+                i++;
+            }
+        }
+
+        updateNs = SDL_GetTicksNS() - start;
+    }
+
+    // fills the vertices for this frame, `offsetX` is the camera, like
+    // GameState::mapViewport.x
+    void build(float offsetX) {
+        drawNs = 0;
+        if (count == 0) {
+            return;
+        }
+        uint64_t start = SDL_GetTicksNS();
+
+        for (int i = 0; i < count; i++) {
+            float half = size[i] / 2;
+            float x = posX[i] - offsetX;
+            float y = posY[i];
+            float fade = 1 - age[i] / life[i];
+            SDL_FColor color = {red[i], green[i], blue[i], alpha[i] * fade};
+
+            SDL_Vertex *quad = &vertices[i * 4];
+            quad[0].position.x = x - half;
+            quad[0].position.y = y - half;
+            quad[1].position.x = x + half;
+            quad[1].position.y = y - half;
+            quad[2].position.x = x + half;
+            quad[2].position.y = y + half;
+            quad[3].position.x = x - half;
+            quad[3].position.y = y + half;
+            for (int corner = 0; corner < 4; corner++) {
+                quad[corner].color = color;
+                quad[corner].tex_coord.x = quad[corner].tex_coord.y = 0;
+            }
+        }
+
+        drawNs = SDL_GetTicksNS() - start;
+    }
+
+    // draws what the last build() made
+    void submit(SDL_Renderer *renderer) {
+        if (count == 0) {
+            return;
+        }
+        uint64_t start = SDL_GetTicksNS();
+
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_RenderGeometry(
+            renderer, NULL, &vertices[0], count * 4, &indices[0], count * 6);
+
+        drawNs += SDL_GetTicksNS() - start;
+    }
+
+    // the screen rect all particles are in, `offsetX` like in build()
+    SDL_FRect getBounds(float offsetX) const {
+        if (count == 0) {
+            SDL_FRect empty = {0, 0, 0, 0};
+            return empty;
+        }
+        float minX = posX[0], maxX = posX[0], minY = posY[0], maxY = posY[0];
+        float maxSize = 0;
+        for (int i = 0; i < count; i++) {
+            minX = std::min(minX, posX[i]);
+            maxX = std::max(maxX, posX[i]);
+            minY = std::min(minY, posY[i]);
+            maxY = std::max(maxY, posY[i]);
+            maxSize = std::max(maxSize, size[i]);
+        }
+        float half = maxSize / 2;
+        SDL_FRect bounds = {
+            minX - half - offsetX,
+            minY - half,
+            maxX - minX + maxSize,
+            maxY - minY + maxSize};
+        return bounds;
+    }
+
+    void clear() { count = 0; }
+    // disabled emit() does nothing, used when replaying frames that already emitted
+    void setEnabled(bool enable) { enabled = enable; }
+
+    int getCount() const { return count; }
+    // how long the last update() and build() plus submit() took
+    uint64_t getUpdateNs() const { return updateNs; }
+    uint64_t getDrawNs() const { return drawNs; }
+
+  private:
+    void move(int from, int to) {
+        posX[to] = posX[from];
+        posY[to] = posY[from];
+        velX[to] = velX[from];
+        velY[to] = velY[from];
+        age[to] = age[from];
+        life[to] = life[from];
+        gravity[to] = gravity[from];
+        size[to] = size[from];
+        red[to] = red[from];
+        green[to] = green[from];
+        blue[to] = blue[from];
+        alpha[to] = alpha[from];
+    }
+
+    // xorshift, between 0 and 1
+    float randomUnit() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return static_cast<float>(seed >> 8) / (1 << 24);
+    }
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef profiler_h
+#define profiler_h
+
+#include "SDL3/SDL_timer.h"
+#include "alloctracker.h"
+#include <cstdint>
+#include <cstdio>
+
+// what each part of a frame cost. the parts are the same ones allocations are tagged
+// with, see AllocTag
+struct FrameProfile {
+    uint64_t frame;
+    uint64_t sectionNs[ALLOC_TAG_COUNT];
+    AllocCounters allocs[ALLOC_TAG_COUNT];
+
+    FrameProfile() : frame(0) {
+        for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+            sectionNs[i] = 0;
+        }
+    }
+};
+
+// times the parts of every frame. enter() moves on to the next part and tags the
+// allocations with it too, so the times and the allocation counts always agree. parts
+// inside another part (shooting happens during the update) use a ProfileScope.
+// OTHER is everything after drawing: presenting and waiting for the next frame
+class FrameProfiler {
+    FrameProfile current, last;
+    AllocTag section;
+    uint64_t sectionStart;
+
+  public:
+    FrameProfiler() : section(AllocTag::OTHER), sectionStart(SDL_GetTicksNS()) {}
+
+    // call right after AllocTracker::beginFrame(), the frame before becomes lastFrame()
+    void beginFrame(uint64_t frame) {
+        enter(AllocTag::OTHER);
+        last = current;
+        for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+            last.allocs[i] = AllocTracker::lastFrame(AllocTag(i));
+        }
+        current = FrameProfile();
+        current.frame = frame;
+    }
+
+    void enter(AllocTag tag) {
+        uint64_t now = SDL_GetTicksNS();
+        current.sectionNs[static_cast<int>(section)] += now - sectionStart;
+        sectionStart = now;
+        section = tag;
+        AllocTracker::setTag(tag);
+    }
+
+    AllocTag getSection() const { return section; }
+    const FrameProfile &lastFrame() const { return last; }
+};
+
+// a part of the frame nested inside another one. its time and allocations go to `tag`
+// instead of the outer part, which picks up again when the scope ends
+class ProfileScope {
+    FrameProfiler &profiler;
+    AllocTag previous;
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+  public:
+    ProfileScope(FrameProfiler &frameProfiler, AllocTag tag)
+        : profiler(frameProfiler), previous(frameProfiler.getSection()) {
+        profiler.enter(tag);
+    }
+    ~ProfileScope() { profiler.enter(previous); }
+};
+
+// writes down the frames that took too long, for finding out later what happened in
+// them (QA playtests, long sessions). every hitch gets its profile and a line about the
+// state of the game appended to the log file
+class HitchRecorder {
+    double threshold;
+    const char *path;
+    int hitches;
+
+  public:
+    HitchRecorder() : threshold(0), path(NULL), hitches(0) {}
+
+    // `thresholdMs` 0 turns it off
+    void init(double thresholdMs, const char *logPath) {
+        threshold = thresholdMs / 1000;
+        path = logPath;
+    }
+
+    bool isHitch(double seconds) const { return threshold > 0 && seconds > threshold; }
+
+    // 💡 goes through C stdio instead of iostreams, it allocates through malloc, which
+    // the alloc test doesn't count
+    void save(const FrameProfile &profile, double seconds, const char *state) {
+        hitches++;
+        std::FILE *file = std::fopen(path, "a");
+        if (!file) {
+            return;
+        }
+        std::fprintf(
+            file,
+            "hitch at frame %llu: %.2fms (over %.2fms)\n  time:",
+            (unsigned long long)profile.frame,
+            seconds * 1000,
+            threshold * 1000);
+        for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+            std::fprintf(
+                file,
+                " %s %.2fms",
+                AllocTracker::getTagName(AllocTag(i)),
+                profile.sectionNs[i] / 1e6);
+        }
+        std::fprintf(file, "\n  allocs:");
+        for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+            std::fprintf(
+                file,
+                " %s %llu (%llu B)",
+                AllocTracker::getTagName(AllocTag(i)),
+                (unsigned long long)profile.allocs[i].allocations,
+                (unsigned long long)profile.allocs[i].bytes);
+        }
+        std::fprintf(file, "\n  state: %s\n", state);
+        std::fclose(file);
+    }
+
+    int getHitches() const { return hitches; }
+    double getThreshold() const { return threshold; }
+    const char *getPath() const { return path; }
+};
+
+#endif
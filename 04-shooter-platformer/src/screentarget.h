@@ -0,0 +1,146 @@
+#ifndef screentarget_h
+#define screentarget_h
+
+#include "SDL3/SDL_rect.h"
+#include "SDL3/SDL_render.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// the game is drawn at its logical size (640x320) into a texture, and that texture is
+// drawn once onto the window, scaled up by a whole number with nearest neighbor so every
+// logical pixel becomes the same square of window pixels. the rest of the window is
+// black bars (letterbox).
+//
+// SDL_SetRenderLogicalPresentation gives the same picture by scaling every draw to the
+// window instead, so each sprite fills window pixels: at 4K the software renderer fills
+// 36 times more pixels per sprite. here drawing the scene costs the same whatever the
+// window size is, only the final copy grows with it. with DirtyRegions even that copy
+// is only done where something changed, see presentRegions().
+//
+// 💡 the texture keeps what was drawn in it between frames, even with the gpu renderers,
+// which is what DirtyRegions needs
+class ScreenTarget {
+    SDL_Texture *texture;
+    int width, height;
+    // how much the last present scaled the texture up
+    float scale;
+
+    // where the texture goes on the window, for the output size below
+    SDL_FRect dest;
+    int outputW, outputH;
+
+    // works out the scale and where the texture goes for the current window size,
+    // returns true when it's not the same as last time
+    bool updateLayout(SDL_Renderer *renderer) {
+        // in real pixels, on high dpi screens the window size isn't
+        int w = 0, h = 0;
+        SDL_GetCurrentRenderOutputSize(renderer, &w, &h);
+        if (w == outputW && h == outputH) {
+            return false;
+        }
+        outputW = w;
+        outputH = h;
+        const float windowW = static_cast<float>(outputW);
+        const float windowH = static_cast<float>(outputH);
+
+        // the biggest whole number that fits. a window smaller than the game gets it
+        // shrunk to fit instead, it can't look right anyway
+        float fit = std::min(windowW / width, windowH / height);
+        scale = fit >= 1 ? std::floor(fit) : fit;
+
+        dest.w = width * scale;
+        dest.h = height * scale;
+        dest.x = std::floor((windowW - dest.w) / 2);
+        dest.y = std::floor((windowH - dest.h) / 2);
+        return true;
+    }
+
+    void presentAll(SDL_Renderer *renderer) {
+        const float windowW = static_cast<float>(outputW);
+        const float windowH = static_cast<float>(outputH);
+
+        // only the bars around it are cleared, the texture covers the rest
+        SDL_FRect bars[4] = {
+            {0, 0, windowW, dest.y},
+            {0, dest.y + dest.h, windowW, windowH - dest.y - dest.h},
+            {0, dest.y, dest.x, dest.h},
+            {dest.x + dest.w, dest.y, windowW - dest.x - dest.w, dest.h}};
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderFillRects(renderer, bars, 4);
+
+        SDL_RenderTexture(renderer, texture, NULL, &dest);
+    }
+
+  public:
+    ScreenTarget()
+        : texture(NULL), width(0), height(0), scale(1), outputW(0), outputH(0) {
+        dest.x = dest.y = dest.w = dest.h = 0;
+    }
+
+    bool init(SDL_Renderer *renderer, int logicalW, int logicalH) {
+        texture = SDL_CreateTexture(
+            renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_TARGET,
+            logicalW,
+            logicalH);
+        if (!texture) {
+            return false;
+        }
+        // the scene is opaque, copying it is enough
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+        width = logicalW;
+        height = logicalH;
+        return true;
+    }
+
+    // what's drawn from here until present() goes into the texture, in logical pixels
+    void begin(SDL_Renderer *renderer) { SDL_SetRenderTarget(renderer, texture); }
+
+    // puts the whole texture on the window, call it right before SDL_RenderPresent()
+    void present(SDL_Renderer *renderer) {
+        SDL_SetRenderTarget(renderer, NULL);
+        updateLayout(renderer);
+        presentAll(renderer);
+    }
+
+    // same, but only `regions` of the texture changed since the last present (logical
+    // pixels, see DirtyRegions), so only they are copied. the rest of the window still
+    // shows last frame, with the bars around it.
+    //
+    // ⚠️ only with the software renderer, it draws into the window surface which keeps
+    // its pixels between frames. the gpu renderers give no such guarantee
+    void presentRegions(SDL_Renderer *renderer, const std::vector<SDL_Rect> &regions) {
+        SDL_SetRenderTarget(renderer, NULL);
+        // a resized window has nothing of last frame on it, and with a scale that isn't
+        // a whole number the regions don't land on whole window pixels
+        if (updateLayout(renderer) || scale != std::floor(scale)) {
+            presentAll(renderer);
+            return;
+        }
+        for (const SDL_Rect &region : regions) {
+            SDL_FRect src;
+            src.x = static_cast<float>(region.x);
+            src.y = static_cast<float>(region.y);
+            src.w = static_cast<float>(region.w);
+            src.h = static_cast<float>(region.h);
+            SDL_FRect dst;
+            dst.x = dest.x + src.x * scale;
+            dst.y = dest.y + src.y * scale;
+            dst.w = src.w * scale;
+            dst.h = src.h * scale;
+            SDL_RenderTexture(renderer, texture, &src, &dst);
+        }
+    }
+
+    float getScale() const { return scale; }
+
+    void destroy() {
+        SDL_DestroyTexture(texture);
+        texture = NULL;
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef snapshot_h
+#define snapshot_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// the state of the simulation at some point, copied into one flat block of bytes.
+//
+// everything written is plain data (ids and handles, no pointers to heap memory), so a
+// snapshot can be copied around with memcpy and saving or restoring the game is a few
+// memcpys instead of deep copies of every object.
+//
+// ⚠️ timer callbacks are function pointers, so a snapshot is only good inside the same
+// run of the game. that's all rollback, retry and rewind need
+class Snapshot {
+    std::vector<uint8_t> bytes;
+    size_t readOffset;
+
+  public:
+    Snapshot() : readOffset(0) {}
+
+    // make sure saving this many bytes doesn't allocate
+    void reserve(size_t size) { bytes.reserve(size); }
+
+    // starts writing a new snapshot, the memory is kept
+    void clear() {
+        bytes.clear();
+        readOffset = 0;
+    }
+
+    // starts reading from the beginning
+    void rewind() { readOffset = 0; }
+
+    template <typename T> void write(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data");
+        writeBytes(&value, sizeof(T));
+    }
+
+    template <typename T, typename A> void writeVector(const std::vector<T, A> &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data");
+        uint32_t count = static_cast<uint32_t>(values.size());
+        write(count);
+        if (count) {
+            writeBytes(values.data(), count * sizeof(T));
+        }
+    }
+
+    template <typename T> void read(T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data");
+        readBytes(&value, sizeof(T));
+    }
+
+    // the vector gets the size it had when saved, it only allocates when that's more
+    // than its capacity
+    template <typename T, typename A> void readVector(std::vector<T, A> &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data");
+        uint32_t count = 0;
+        read(count);
+        values.resize(count);
+        if (count) {
+            readBytes(values.data(), count * sizeof(T));
+        }
+    }
+
+    size_t size() const { return bytes.size(); }
+    size_t capacity() const { return bytes.capacity(); }
+
+  private:
+    void writeBytes(const void *data, size_t size) {
+        size_t offset = bytes.size();
+        bytes.resize(offset + size);
+        std::memcpy(&bytes[offset], data, size);
+    }
+
+    void readBytes(void *data, size_t size) {
+        std::memcpy(data, &bytes[readOffset], size);
+        readOffset += size;
+    }
+};
+
+// the last frames of the game: the state at the start of each frame and the input the
+// frame ran with. going back N frames and simulating them again with the same input has
+// to end in the same state, which is what rollback netcode is built on
+template <typename Input> class SnapshotHistory {
+    std::vector<Snapshot> states;
+    std::vector<Input> inputs;
+    // where the next frame goes, the oldest one when full
+    int next;
+    int count;
+
+  public:
+    SnapshotHistory() : next(0), count(0) {}
+
+    // `frames` is how far back we can go, `snapshotSize` how big the biggest snapshot
+    // gets, so recording never allocates
+    void init(int frames, size_t snapshotSize) {
+        states.resize(frames);
+        inputs.resize(frames);
+        for (size_t i = 0; i < states.size(); i++) {
+            states[i].reserve(snapshotSize);
+        }
+        next = count = 0;
+    }
+
+    // makes room for a new frame, overwriting the oldest one when full. returns the
+    // snapshot to save the frame's state in, the input is set with setLatestInput()
+    Snapshot &push() {
+        Snapshot &snapshot = states[next];
+        snapshot.clear();
+        next = (next + 1) % capacity();
+        if (count < capacity()) {
+            count++;
+        }
+        return snapshot;
+    }
+
+    void setLatestInput(const Input &input) { inputs[index(0)] = input; }
+
+    // 0 is the latest frame
+    Snapshot &state(int framesAgo) { return states[index(framesAgo)]; }
+    const Input &input(int framesAgo) const { return inputs[index(framesAgo)]; }
+
+    void clear() { next = count = 0; }
+
+    // forgets the latest frame
+    void pop() {
+        if (count > 0) {
+            next = (next + capacity() - 1) % capacity();
+            count--;
+        }
+    }
+
+    int size() const { return count; }
+    int capacity() const { return static_cast<int>(states.size()); }
+
+  private:
+    int index(int framesAgo) const {
+        return (next + capacity() - 1 - framesAgo) % capacity();
+    }
+};
+
+#endif
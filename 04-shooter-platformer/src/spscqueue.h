@@ -0,0 +1,53 @@
+#ifndef spscqueue_h
+#define spscqueue_h
+
+#include <atomic>
+#include <cstddef>
+
+// fixed size queue for exactly one producer thread and one consumer thread, neither of
+// them ever locks or allocates.
+//
+// head and tail only grow, the slot is the index masked by the capacity (that's why it
+// must be a power of 2). each index is written by a single thread:
+// - the producer writes the item and then publishes it by moving tail (release)
+// - the consumer sees the new tail (acquire), so the item is guaranteed to be written
+// and the same the other way around for head, so the producer never overwrites an item
+// that wasn't read yet
+template <typename T, size_t CAPACITY> class SpscQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of 2");
+    static const size_t MASK = CAPACITY - 1;
+
+    T items[CAPACITY];
+
+    // 💡 each index in its own cache line, otherwise both threads keep stealing the same
+    // line from each other even though they write different variables (false sharing)
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+
+  public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // producer only, false when the queue is full
+    bool push(const T &item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+        items[t & MASK] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only, false when the queue is empty
+    bool pop(T &item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif
@@ -8,10 +8,9 @@
 struct SDLState {
     SDL_Window *window;
     SDL_Renderer *renderer;
-    // logW and logH means logical width/height it's used by
-    // SDL_SetRenderLogicalPresentation to make a logical width of our game without us
-    // having to worry about window resize and screen resolution, width and height here
-    // are the actual widnow size on the client
+    // logW and logH means logical width/height, the size the game is drawn at (see
+    // ScreenTarget) so we don't have to worry about window resize and screen
+    // resolution, width and height here are the actual widnow size on the client
     int width, height, logW, logH;
 
     const bool *keys;
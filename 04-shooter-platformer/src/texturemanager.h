@@ -0,0 +1,275 @@
+#ifndef texturemanager_h
+#define texturemanager_h
+
+#include "SDL3/SDL_pixels.h"
+#include "SDL3/SDL_properties.h"
+#include "SDL3/SDL_render.h"
+#include "SDL3/SDL_surface.h"
+#include <SDL3_image/SDL_image.h>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <vector>
+
+// index of a texture in the TextureManager, stays valid while the texture itself comes
+// and goes
+typedef int TextureHandle;
+const TextureHandle NO_TEXTURE = -1;
+
+// owns every texture of the game. textures are registered by path up front but only
+// loaded the first time something asks for them, and they're unloaded again when they
+// haven't been used for a while or when we're over the memory budget (least recently
+// used first). so the textures on the GPU are the ones the game is actually drawing,
+// not everything that exists in the assets folder.
+//
+// ⚠️ get() marks the texture as used this frame, and textures used this frame are never
+// evicted, so pointers from get() are only good until the next beginFrame()
+//
+// with compact textures, sheets that can go to 16 bits per pixel without looking any
+// different are loaded that way, half the memory of the usual 32. see compactFormat()
+class TextureManager {
+    struct Entry {
+        // paths are string literals, no copies
+        const char *path;
+        SDL_Texture *texture;
+        // known after the first load, so sizes can be asked without reloading
+        int width, height;
+        SDL_PixelFormat format;
+        size_t bytes;
+        uint64_t lastUsedFrame;
+    };
+
+    SDL_Renderer *renderer;
+    std::vector<Entry> entries;
+
+    size_t budgetBytes;
+    // unused textures are evicted after this many frames, even under the budget
+    uint64_t evictAfterFrames;
+    bool compact;
+
+    uint64_t frame;
+    size_t residentBytes;
+    int residentCount;
+    uint64_t loads, evictions;
+
+  public:
+    TextureManager()
+        : renderer(NULL), budgetBytes(64 * 1024 * 1024), evictAfterFrames(600),
+          compact(false), frame(0), residentBytes(0), residentCount(0), loads(0),
+          evictions(0) {}
+
+    ~TextureManager() { unloadAll(); }
+
+    void init(SDL_Renderer *r, size_t budget, uint64_t evictFrames, bool compactFormats) {
+        renderer = r;
+        budgetBytes = budget;
+        evictAfterFrames = evictFrames;
+        compact = compactFormats;
+    }
+
+    // registers the texture, nothing is loaded yet
+    TextureHandle add(const char *path) {
+        Entry entry;
+        entry.path = path;
+        entry.texture = NULL;
+        entry.width = entry.height = 0;
+        entry.format = SDL_PIXELFORMAT_UNKNOWN;
+        entry.bytes = 0;
+        entry.lastUsedFrame = 0;
+        entries.push_back(entry);
+        return static_cast<TextureHandle>(entries.size()) - 1;
+    }
+
+    // the texture, loading it if needed. NULL if the file can't be loaded
+    SDL_Texture *get(TextureHandle handle) {
+        if (handle < 0 || handle >= static_cast<int>(entries.size())) {
+            return NULL;
+        }
+        Entry &entry = entries[handle];
+        entry.lastUsedFrame = frame;
+        if (!entry.texture) {
+            load(entry);
+        }
+        return entry.texture;
+    }
+
+    int getWidth(TextureHandle handle) { return size(handle).width; }
+    int getHeight(TextureHandle handle) { return size(handle).height; }
+
+    // call once at the start of every frame, before anything calls get()
+    void beginFrame() {
+        frame++;
+        for (size_t i = 0; i < entries.size(); i++) {
+            Entry &entry = entries[i];
+            if (entry.texture && frame - entry.lastUsedFrame > evictAfterFrames) {
+                evict(entry);
+            }
+        }
+    }
+
+    void unloadAll() {
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].texture) {
+                evict(entries[i]);
+            }
+        }
+    }
+
+    size_t getResidentBytes() const { return residentBytes; }
+    size_t getBudgetBytes() const { return budgetBytes; }
+    int getResidentCount() const { return residentCount; }
+    int getCount() const { return static_cast<int>(entries.size()); }
+    uint64_t getLoads() const { return loads; }
+    uint64_t getEvictions() const { return evictions; }
+
+    // every texture with its size, format, memory and the frame it was last drawn.
+    // textures that were never loaded show up without size
+    void printReport(std::ostream &out) const {
+        size_t loadedBytes = 0, fullBytes = 0;
+        out << "Textures at frame " << frame << ":" << std::endl;
+        for (size_t i = 0; i < entries.size(); i++) {
+            const Entry &entry = entries[i];
+            out << "  " << (entry.texture ? "resident " : "unloaded ") << entry.path;
+            if (entry.width > 0) {
+                out << " " << entry.width << "x" << entry.height << " "
+                    << SDL_GetPixelFormatName(entry.format) << " " << entry.bytes / 1024
+                    << " KB, last used at frame " << entry.lastUsedFrame;
+                loadedBytes += entry.bytes;
+                fullBytes += static_cast<size_t>(entry.width) * entry.height * 4;
+            }
+            out << std::endl;
+        }
+        out << "  resident " << residentBytes / 1024 << " KB in " << residentCount
+            << " textures, all loaded ones take " << loadedBytes / 1024 << " KB ("
+            << fullBytes / 1024 << " KB at 32 bits per pixel)" << std::endl;
+    }
+
+  private:
+    // sizes without marking the texture as used
+    const Entry &size(TextureHandle handle) {
+        Entry &entry = entries[handle];
+        if (entry.width == 0 && !entry.texture) {
+            load(entry);
+        }
+        return entry;
+    }
+
+    void load(Entry &entry) {
+        entry.texture =
+            compact ? loadCompact(entry.path) : IMG_LoadTexture(renderer, entry.path);
+        if (!entry.texture) {
+            std::cerr << "IMG_LoadTexture failed: " << entry.path << SDL_GetError()
+                      << std::endl;
+            return;
+        }
+        // this makes the sprite to be streched without "antialiasing"
+        SDL_SetTextureScaleMode(entry.texture, SDL_SCALEMODE_NEAREST);
+
+        entry.width = entry.texture->w;
+        entry.height = entry.texture->h;
+        entry.format = entry.texture->format;
+        // what the pixels take on the GPU, ignoring whatever padding the driver adds
+        entry.bytes = static_cast<size_t>(entry.width) * entry.height *
+                      SDL_BYTESPERPIXEL(entry.texture->format);
+        residentBytes += entry.bytes;
+        residentCount++;
+        loads++;
+
+        evictOverBudget();
+    }
+
+    // like IMG_LoadTexture, but in 16 bits when compactFormat() finds one good enough and
+    // the renderer takes it
+    SDL_Texture *loadCompact(const char *path) {
+        SDL_Surface *loaded = IMG_Load(path);
+        if (!loaded) {
+            return NULL;
+        }
+        SDL_Surface *rgba = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+        SDL_DestroySurface(loaded);
+        if (!rgba) {
+            return NULL;
+        }
+
+        SDL_Surface *converted = NULL;
+        SDL_PixelFormat format = compactFormat(rgba);
+        if (format != SDL_PIXELFORMAT_UNKNOWN && isSupported(format)) {
+            converted = SDL_ConvertSurface(rgba, format);
+        }
+        SDL_Texture *texture =
+            SDL_CreateTextureFromSurface(renderer, converted ? converted : rgba);
+        SDL_DestroySurface(converted);
+        SDL_DestroySurface(rgba);
+        return texture;
+    }
+
+    // a 16 bit format that keeps what matters of the pixels, or UNKNOWN to stay in 32.
+    // colors lose their lowest bits either way, which pixel art at our sizes doesn't
+    // show. alpha is what decides:
+    // - opaque (backgrounds): RGB565, no alpha at all
+    // - fully transparent or fully opaque pixels (most sprites): ARGB1555, one bit of
+    //   alpha is enough
+    // - anything in between (soft edges, glows): 4 bits of alpha would band, stays in 32
+    static SDL_PixelFormat compactFormat(const SDL_Surface *rgba) {
+        bool opaque = true;
+        for (int y = 0; y < rgba->h; y++) {
+            const uint8_t *row =
+                static_cast<const uint8_t *>(rgba->pixels) + y * rgba->pitch;
+            for (int x = 0; x < rgba->w; x++) {
+                // RGBA32 is r, g, b, a in memory
+                uint8_t alpha = row[x * 4 + 3];
+                if (alpha != 255) {
+                    opaque = false;
+                    if (alpha != 0) {
+                        return SDL_PIXELFORMAT_UNKNOWN;
+                    }
+                }
+            }
+        }
+        return opaque ? SDL_PIXELFORMAT_RGB565 : SDL_PIXELFORMAT_ARGB1555;
+    }
+
+    bool isSupported(SDL_PixelFormat format) const {
+        const SDL_PixelFormat *formats = static_cast<const SDL_PixelFormat *>(
+            SDL_GetPointerProperty(
+                SDL_GetRendererProperties(renderer),
+                SDL_PROP_RENDERER_TEXTURE_FORMATS_POINTER,
+                NULL));
+        for (int i = 0; formats && formats[i] != SDL_PIXELFORMAT_UNKNOWN; i++) {
+            if (formats[i] == format) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void evict(Entry &entry) {
+        SDL_DestroyTexture(entry.texture);
+        entry.texture = NULL;
+        residentBytes -= entry.bytes;
+        residentCount--;
+        evictions++;
+    }
+
+    // evicts the least recently used textures until we fit in the budget again. the ones
+    // used this frame stay, even if that means going over it
+    void evictOverBudget() {
+        while (residentBytes > budgetBytes) {
+            Entry *oldest = NULL;
+            for (size_t i = 0; i < entries.size(); i++) {
+                Entry &entry = entries[i];
+                if (entry.texture && entry.lastUsedFrame < frame &&
+                    (!oldest || entry.lastUsedFrame < oldest->lastUsedFrame)) {
+                    oldest = &entry;
+                }
+            }
+            if (!oldest) {
+                return;
+            }
+            evict(*oldest);
+        }
+    }
+};
+
+#endif
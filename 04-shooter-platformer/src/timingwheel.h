@@ -0,0 +1,252 @@
+#ifndef timingwheel_h
+#define timingwheel_h
+
+#include "snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// called when a timer expires. context and data are whatever was given to schedule(),
+// usually the GameState and the index of an object
+typedef void (*TimerCallback)(void *context, int data);
+
+// identifies a scheduled timer. the generation makes old handles harmless: once a timer
+// fired or was cancelled its node is reused with a new generation, so cancelling through
+// an old handle does nothing
+struct TimerHandle {
+    int index;
+    uint32_t generation;
+    TimerHandle() : index(-1), generation(0) {}
+};
+
+// schedules callbacks in the future. unlike a countdown, which has to be stepped every
+// frame even while nothing is happening, a scheduled timer costs nothing until the tick
+// it expires in.
+//
+// time is split in ticks, and timers are kept in buckets (slots) by the tick they expire
+// at. a single ring of slots would need a slot for every tick of the longest timer, so
+// there are several rings (levels), each slot of a level covers a whole turn of the level
+// below it:
+// - level 0: 64 slots of 1 tick
+// - level 1: 64 slots of 64 ticks
+// - level 2: 64 slots of 4096 ticks ...
+// when level 0 completes a turn, the next slot of level 1 is emptied and its timers are
+// put back in level 0 (cascading), now that they're close enough to have their own slot
+class TimingWheel {
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const uint64_t SLOT_MASK = SLOTS - 1;
+
+    struct TimerNode {
+        uint64_t expiresAt;
+        TimerCallback callback;
+        void *context;
+        int data;
+        uint32_t generation;
+        bool pending;
+        // doubly linked list of the slot the timer is in, or of the free list
+        int prev, next;
+        int level, slot;
+    };
+
+    float tickLength;
+    // time that didn't make a whole tick yet
+    float accumulator;
+    uint64_t currentTick;
+
+    std::vector<TimerNode> nodes;
+    int freeList;
+    int pendingCount;
+
+    // first node of each slot, -1 when empty
+    int slots[LEVELS][SLOTS];
+
+  public:
+    explicit TimingWheel(float tick = 0.001f)
+        : tickLength(tick), accumulator(0), currentTick(0), freeList(-1),
+          pendingCount(0) {
+        for (int level = 0; level < LEVELS; level++) {
+            for (int slot = 0; slot < SLOTS; slot++) {
+                slots[level][slot] = -1;
+            }
+        }
+    }
+
+    // makes sure this many timers can be pending without allocating
+    void reserve(size_t count) { nodes.reserve(count); }
+
+    TimerHandle schedule(float seconds, TimerCallback callback, void *context, int data) {
+        int index = allocateNode();
+        TimerNode &node = nodes[index];
+
+        // a timer always waits at least one tick, even a 0s one, so a callback that
+        // schedules another timer can't make advance() loop forever
+        uint64_t ticks = static_cast<uint64_t>(seconds / tickLength + 0.5f);
+        node.expiresAt = currentTick + (ticks > 0 ? ticks : 1);
+        node.callback = callback;
+        node.context = context;
+        node.data = data;
+        node.pending = true;
+        insert(index);
+        pendingCount++;
+
+        TimerHandle handle;
+        handle.index = index;
+        handle.generation = node.generation;
+        return handle;
+    }
+
+    // returns whether the timer was pending, it's safe to cancel an expired timer
+    bool cancel(TimerHandle &handle) {
+        if (!isPending(handle)) {
+            handle = TimerHandle();
+            return false;
+        }
+        unlink(handle.index);
+        releaseNode(handle.index);
+        pendingCount--;
+        handle = TimerHandle();
+        return true;
+    }
+
+    bool isPending(const TimerHandle &handle) const {
+        return handle.index >= 0 && handle.index < static_cast<int>(nodes.size()) &&
+               nodes[handle.index].generation == handle.generation &&
+               nodes[handle.index].pending;
+    }
+
+    // seconds until the timer expires, 0 if it isn't pending
+    float getRemaining(const TimerHandle &handle) const {
+        if (!isPending(handle)) {
+            return 0;
+        }
+        return (nodes[handle.index].expiresAt - currentTick) * tickLength - accumulator;
+    }
+
+    // every timer and where the wheel is at, see snapshot.h. the callbacks and contexts
+    // are saved as they are
+    void save(Snapshot &snapshot) const {
+        snapshot.write(accumulator);
+        snapshot.write(currentTick);
+        snapshot.writeVector(nodes);
+        snapshot.write(freeList);
+        snapshot.write(pendingCount);
+        snapshot.write(slots);
+    }
+
+    void restore(Snapshot &snapshot) {
+        snapshot.read(accumulator);
+        snapshot.read(currentTick);
+        snapshot.readVector(nodes);
+        snapshot.read(freeList);
+        snapshot.read(pendingCount);
+        snapshot.read(slots);
+    }
+
+    void advance(float deltaTime) {
+        accumulator += deltaTime;
+        while (accumulator >= tickLength) {
+            accumulator -= tickLength;
+            tick();
+        }
+    }
+
+    int getPendingCount() const { return pendingCount; }
+
+  private:
+    void tick() {
+        currentTick++;
+
+        // when a level wraps around, bring the timers of the next slot above down
+        for (int level = 1; level < LEVELS; level++) {
+            uint64_t lowerBits = currentTick & ((1ull << (level * SLOT_BITS)) - 1);
+            if (lowerBits != 0) {
+                break;
+            }
+            cascade(level, (currentTick >> (level * SLOT_BITS)) & SLOT_MASK);
+        }
+
+        // fire everything in this tick's slot. one at a time, and the node is freed
+        // before its callback runs, so callbacks can schedule and cancel timers
+        int &head = slots[0][currentTick & SLOT_MASK];
+        while (head != -1) {
+            int index = head;
+            TimerNode node = nodes[index];
+            unlink(index);
+            releaseNode(index);
+            pendingCount--;
+            node.callback(node.context, node.data);
+        }
+    }
+
+    void cascade(int level, uint64_t slot) {
+        int index = slots[level][slot];
+        slots[level][slot] = -1;
+        while (index != -1) {
+            int next = nodes[index].next;
+            insert(index);
+            index = next;
+        }
+    }
+
+    // puts the node in the slot matching how far away it expires
+    void insert(int index) {
+        TimerNode &node = nodes[index];
+        uint64_t delta = node.expiresAt > currentTick ? node.expiresAt - currentTick : 0;
+
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (1ull << ((level + 1) * SLOT_BITS))) {
+            level++;
+        }
+        // ⚠️ longer than the wheel can hold (~4.6 hours with 1ms ticks), it will be put
+        // back in the wheel with whatever is left when its slot cascades
+        uint64_t maxDelta = (1ull << (LEVELS * SLOT_BITS)) - 1;
+        uint64_t expiresAt = delta > maxDelta ? currentTick + maxDelta : node.expiresAt;
+
+        node.level = level;
+        node.slot = static_cast<int>((expiresAt >> (level * SLOT_BITS)) & SLOT_MASK);
+        node.prev = -1;
+        node.next = slots[level][node.slot];
+        if (node.next != -1) {
+            nodes[node.next].prev = index;
+        }
+        slots[level][node.slot] = index;
+    }
+
+    void unlink(int index) {
+        TimerNode &node = nodes[index];
+        if (node.prev != -1) {
+            nodes[node.prev].next = node.next;
+        } else {
+            slots[node.level][node.slot] = node.next;
+        }
+        if (node.next != -1) {
+            nodes[node.next].prev = node.prev;
+        }
+        node.prev = node.next = -1;
+    }
+
+    int allocateNode() {
+        if (freeList == -1) {
+            TimerNode node = TimerNode();
+            node.prev = node.next = -1;
+            nodes.push_back(node);
+            return static_cast<int>(nodes.size()) - 1;
+        }
+        int index = freeList;
+        freeList = nodes[index].next;
+        return index;
+    }
+
+    void releaseNode(int index) {
+        TimerNode &node = nodes[index];
+        node.pending = false;
+        // old handles to this node stop matching
+        node.generation++;
+        node.next = freeList;
+        freeList = index;
+    }
+};
+
+#endif